@@ -0,0 +1,176 @@
+#include "sql/arrow.h"
+
+#include <cassert>
+#include <memory>
+#include <vector>
+
+namespace sql {
+
+namespace {
+
+// Non-null placeholder for empty buffers.
+alignas(64) const uint8_t kEmptyBuffer[64] = {};
+
+const char* GetArrowFormat(field_type type) {
+  switch (type) {
+    case field_type::INTEGER:
+      return "l";
+    case field_type::FLOAT:
+      return "g";
+    case field_type::TEXT:
+      return "u";
+    case field_type::BLOB:
+      return "z";
+    case field_type::EMPTY:
+      return "n";
+  }
+  assert(false);
+  return "n";
+}
+
+template <class T>
+const void* GetBuffer(std::span<const T> buffer) {
+  return buffer.empty() ? static_cast<const void*>(kEmptyBuffer)
+                        : buffer.data();
+}
+
+// Schema
+
+struct SchemaData {
+  std::string name;
+  std::vector<ArrowSchema> children;
+  std::vector<ArrowSchema*> child_pointers;
+};
+
+void ReleaseSchema(ArrowSchema* schema) {
+  auto* data = static_cast<SchemaData*>(schema->private_data);
+  for (auto& child : data->children) {
+    if (child.release)
+      child.release(&child);
+  }
+  delete data;
+  schema->release = nullptr;
+}
+
+void InitSchema(ArrowSchema& schema,
+                const char* format,
+                std::unique_ptr<SchemaData> data) {
+  schema = {.format = format,
+            .name = data->name.c_str(),
+            .metadata = nullptr,
+            .flags = 0,
+            .n_children = static_cast<int64_t>(data->child_pointers.size()),
+            .children = data->child_pointers.data(),
+            .dictionary = nullptr,
+            .release = &ReleaseSchema,
+            .private_data = data.release()};
+}
+
+// Array
+
+// Each array keeps the batch alive on its own, as a consumer may move the
+// children out and release the parent first.
+struct ArrayData {
+  std::shared_ptr<const column_batch> batch;
+  std::vector<const void*> buffers;
+  std::vector<ArrowArray> children;
+  std::vector<ArrowArray*> child_pointers;
+};
+
+void ReleaseArray(ArrowArray* array) {
+  auto* data = static_cast<ArrayData*>(array->private_data);
+  for (auto& child : data->children) {
+    if (child.release)
+      child.release(&child);
+  }
+  delete data;
+  array->release = nullptr;
+}
+
+void InitArray(ArrowArray& array,
+               int64_t length,
+               int64_t null_count,
+               std::unique_ptr<ArrayData> data) {
+  array = {.length = length,
+           .null_count = null_count,
+           .offset = 0,
+           .n_buffers = static_cast<int64_t>(data->buffers.size()),
+           .n_children = static_cast<int64_t>(data->child_pointers.size()),
+           .buffers = data->buffers.data(),
+           .children = data->child_pointers.data(),
+           .dictionary = nullptr,
+           .release = &ReleaseArray,
+           .private_data = data.release()};
+}
+
+std::vector<const void*> GetColumnBuffers(const column_vector& column) {
+  const void* validity =
+      column.null_count() == 0 ? nullptr : GetBuffer(column.validity());
+  switch (column.type()) {
+    case field_type::INTEGER:
+      return {validity, GetBuffer(column.integers())};
+    case field_type::FLOAT:
+      return {validity, GetBuffer(column.floats())};
+    case field_type::TEXT:
+    case field_type::BLOB:
+      return {validity, GetBuffer(column.offsets()),
+              GetBuffer(column.bytes())};
+    case field_type::EMPTY:
+      return {};
+  }
+  assert(false);
+  return {};
+}
+
+}  // namespace
+
+void export_arrow_schema(const column_batch& batch,
+                         std::span<const column_info> columns,
+                         ArrowSchema* schema) {
+  auto data = std::make_unique<SchemaData>();
+  data->children.resize(batch.column_count());
+  data->child_pointers.resize(batch.column_count());
+
+  for (size_t i = 0; i < batch.column_count(); ++i) {
+    auto child_data = std::make_unique<SchemaData>();
+    bool nullable = true;
+    if (i < columns.size()) {
+      child_data->name = columns[i].name;
+      nullable = columns[i].nullable.value_or(true);
+    }
+    auto& child = data->children[i];
+    InitSchema(child, GetArrowFormat(batch.column(i).type()),
+               std::move(child_data));
+    child.flags = nullable ? ARROW_FLAG_NULLABLE : 0;
+    data->child_pointers[i] = &child;
+  }
+
+  InitSchema(*schema, "+s", std::move(data));
+}
+
+void export_arrow_array(column_batch&& batch, ArrowArray* array) {
+  auto shared_batch = std::make_shared<const column_batch>(std::move(batch));
+
+  auto data = std::make_unique<ArrayData>();
+  data->batch = shared_batch;
+  data->buffers = {nullptr};
+  data->children.resize(shared_batch->column_count());
+  data->child_pointers.resize(shared_batch->column_count());
+
+  for (size_t i = 0; i < shared_batch->column_count(); ++i) {
+    const auto& column = shared_batch->column(i);
+    auto child_data = std::make_unique<ArrayData>();
+    child_data->batch = shared_batch;
+    child_data->buffers = GetColumnBuffers(column);
+    auto& child = data->children[i];
+    InitArray(child, static_cast<int64_t>(column.size()),
+              static_cast<int64_t>(column.null_count()),
+              std::move(child_data));
+    data->child_pointers[i] = &child;
+  }
+
+  InitArray(*array, static_cast<int64_t>(shared_batch->row_count()), 0,
+            std::move(data));
+}
+
+}  // namespace sql
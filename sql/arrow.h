@@ -0,0 +1,108 @@
+#pragma once
+
+#include "sql/column_batch.h"
+
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+// The Arrow C data interface ABI, see
+// https://arrow.apache.org/docs/format/CDataInterface.html. The definitions
+// are shared with any other copy of the header through the guard.
+extern "C" {
+
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+struct ArrowSchema {
+  // Array type description
+  const char* format;
+  const char* name;
+  const char* metadata;
+  int64_t flags;
+  int64_t n_children;
+  struct ArrowSchema** children;
+  struct ArrowSchema* dictionary;
+
+  // Release callback
+  void (*release)(struct ArrowSchema*);
+  // Opaque producer-specific data
+  void* private_data;
+};
+
+struct ArrowArray {
+  // Array data description
+  int64_t length;
+  int64_t null_count;
+  int64_t offset;
+  int64_t n_buffers;
+  int64_t n_children;
+  const void** buffers;
+  struct ArrowArray** children;
+  struct ArrowArray* dictionary;
+
+  // Release callback
+  void (*release)(struct ArrowArray*);
+  // Opaque producer-specific data
+  void* private_data;
+};
+
+#endif  // ARROW_C_DATA_INTERFACE
+
+}  // extern "C"
+
+namespace sql {
+
+// Exports the types of the |batch| columns as an Arrow struct schema:
+// `INTEGER` as int64, `FLOAT` as float64, `TEXT` as utf8, `BLOB` as binary
+// and `EMPTY` as null. Fields are named after |columns| and are nullable
+// unless known otherwise.
+void export_arrow_schema(const column_batch& batch,
+                         std::span<const column_info> columns,
+                         ArrowSchema* schema);
+
+// Exports |batch| as an Arrow struct array matching `export_arrow_schema`.
+// The column buffers are handed over without copying and stay alive until
+// the array and all children moved out of it are released.
+void export_arrow_array(column_batch&& batch, ArrowArray* array);
+
+// Fetches up to |max_rows| rows of |statement| into |batch| and exports them.
+// Returns the row count, or 0 once the rows are exhausted, in which case
+// nothing is exported. The buffers of |batch| are handed over to |array|, but
+// its column types are kept, so pass the same |batch| for all the batches of
+// |statement| to export the same schema. Only a column with neither a known
+// declared type nor a non-NULL value so far is exported as null and can get a
+// type later.
+template <class Statement>
+size_t export_arrow_batch(Statement& statement,
+                          column_batch& batch,
+                          size_t max_rows,
+                          ArrowSchema* schema,
+                          ArrowArray* array) {
+  size_t row_count = statement.fetch_batch(batch, max_rows);
+  if (row_count == 0)
+    return 0;
+  export_arrow_schema(batch, statement.columns(), schema);
+
+  std::vector<field_type> types;
+  for (const auto& column : batch.columns())
+    types.emplace_back(column.type());
+
+  export_arrow_array(std::move(batch), array);
+
+  batch = column_batch{};
+  batch.clear(types.size());
+  for (size_t i = 0; i < types.size(); ++i) {
+    if (types[i] != field_type::EMPTY)
+      batch.column(i).set_type(types[i]);
+  }
+
+  return row_count;
+}
+
+}  // namespace sql
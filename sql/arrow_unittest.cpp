@@ -0,0 +1,108 @@
+#include "sql/arrow.h"
+
+#include "sql/connection.h"
+#include "sql/statement.h"
+#include "sql/test/temp_dir.h"
+
+#include <gmock/gmock.h>
+#include <string_view>
+#include <vector>
+
+using namespace testing;
+
+namespace sql {
+
+class ArrowTest : public Test {
+ public:
+  virtual void SetUp() override {
+    connection_.open({.path = temp_dir_.get() / "database.sqlite3"});
+    connection_.query("CREATE TABLE t(a INTEGER, b REAL, c TEXT, d)");
+    connection_.query(
+        "INSERT INTO t VALUES(1, 1.5, 'one', NULL), (2, NULL, 'two', NULL),"
+        "(3, 3.5, NULL, NULL)");
+  }
+
+ protected:
+  ScopedTempDir temp_dir_;
+  connection connection_;
+};
+
+TEST_F(ArrowTest, ExportsBatch) {
+  statement statement{connection_, "SELECT a, b, c, d FROM t ORDER BY a"};
+
+  column_batch batch;
+  ArrowSchema schema;
+  ArrowArray array;
+  ASSERT_EQ(3u, export_arrow_batch(statement, batch, 10, &schema, &array));
+
+  EXPECT_STREQ("+s", schema.format);
+  ASSERT_EQ(4, schema.n_children);
+  EXPECT_STREQ("l", schema.children[0]->format);
+  EXPECT_STREQ("a", schema.children[0]->name);
+  EXPECT_EQ(ARROW_FLAG_NULLABLE, schema.children[0]->flags);
+  EXPECT_STREQ("g", schema.children[1]->format);
+  EXPECT_STREQ("b", schema.children[1]->name);
+  EXPECT_STREQ("u", schema.children[2]->format);
+  EXPECT_STREQ("n", schema.children[3]->format);
+
+  EXPECT_EQ(3, array.length);
+  ASSERT_EQ(4, array.n_children);
+
+  const ArrowArray& a = *array.children[0];
+  EXPECT_EQ(0, a.null_count);
+  ASSERT_EQ(2, a.n_buffers);
+  EXPECT_EQ(nullptr, a.buffers[0]);
+  const auto* integers = static_cast<const int64_t*>(a.buffers[1]);
+  EXPECT_THAT(std::vector(integers, integers + 3), ElementsAre(1, 2, 3));
+
+  const ArrowArray& b = *array.children[1];
+  EXPECT_EQ(1, b.null_count);
+  EXPECT_EQ(0b101, *static_cast<const uint8_t*>(b.buffers[0]));
+  EXPECT_EQ(3.5, static_cast<const double*>(b.buffers[1])[2]);
+
+  const ArrowArray& c = *array.children[2];
+  ASSERT_EQ(3, c.n_buffers);
+  const auto* offsets = static_cast<const int32_t*>(c.buffers[1]);
+  EXPECT_THAT(std::vector(offsets, offsets + 4), ElementsAre(0, 3, 6, 6));
+  EXPECT_EQ("onetwo",
+            std::string_view(static_cast<const char*>(c.buffers[2]), 6));
+
+  const ArrowArray& d = *array.children[3];
+  EXPECT_EQ(0, d.n_buffers);
+  EXPECT_EQ(3, d.null_count);
+
+  // A child moved out of the array outlives it.
+  ArrowArray moved = *array.children[2];
+  array.children[2]->release = nullptr;
+  array.release(&array);
+  EXPECT_EQ(nullptr, array.release);
+  EXPECT_EQ("onetwo",
+            std::string_view(static_cast<const char*>(moved.buffers[2]), 6));
+  moved.release(&moved);
+
+  schema.release(&schema);
+  EXPECT_EQ(nullptr, schema.release);
+
+  EXPECT_EQ(0u, export_arrow_batch(statement, batch, 10, &schema, &array));
+}
+
+TEST_F(ArrowTest, KeepsSchemaAcrossBatches) {
+  // A NULL before a value takes the declared type. A NULL after a value of an
+  // expression keeps its type.
+  for (const char* sql : {"SELECT b FROM t WHERE a IN (2, 3) ORDER BY a",
+                          "SELECT b * 2 FROM t WHERE a IN (1, 2) ORDER BY a"}) {
+    statement statement{connection_, sql};
+    column_batch batch;
+
+    for (int i = 0; i < 2; ++i) {
+      ArrowSchema schema;
+      ArrowArray array;
+      ASSERT_EQ(1u, export_arrow_batch(statement, batch, 1, &schema, &array));
+      EXPECT_STREQ("g", schema.children[0]->format) << sql;
+      array.release(&array);
+      schema.release(&schema);
+    }
+  }
+}
+
+}  // namespace sql
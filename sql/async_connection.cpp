@@ -0,0 +1,92 @@
+#include "sql/async_connection.h"
+
+namespace sql {
+
+async_statement& async_statement::operator=(
+    async_statement&& source) noexcept {
+  if (this != &source) {
+    Close();
+    connection_ = std::exchange(source.connection_, nullptr);
+    lifetime_ = std::move(source.lifetime_);
+    state_ = std::exchange(source.state_, nullptr);
+  }
+  return *this;
+}
+
+async_statement::async_statement(async_connection& connection, state* state)
+    : connection_{&connection},
+      lifetime_{connection.lifetime_},
+      state_{state} {}
+
+async_statement::~async_statement() {
+  Close();
+}
+
+void async_statement::Close() {
+  if (!state_)
+    return;
+
+  // Queued before the worker stops, or the statement is already deleted.
+  std::lock_guard lock{lifetime_->mutex};
+  if (lifetime_->alive) {
+    connection_->Post([connection = connection_, state = state_] {
+      connection->statements_.erase(state);
+      delete state;
+    });
+  }
+  state_ = nullptr;
+}
+
+async_connection::async_connection() {
+  thread_ = std::thread{[this] { Run(); }};
+}
+
+async_connection::~async_connection() {
+  {
+    std::lock_guard lock{lifetime_->mutex};
+    lifetime_->alive = false;
+  }
+  queue_.push({});
+  thread_.join();
+}
+
+async_result<void> async_connection::open(open_params params) {
+  return Post([this, params = std::move(params)] { connection_.open(params); });
+}
+
+async_result<void> async_connection::close() {
+  return Post([this] { connection_.close(); });
+}
+
+async_result<void> async_connection::query(std::string sql) {
+  return Post([this, sql = std::move(sql)] { connection_.query(sql); });
+}
+
+async_result<async_statement> async_connection::prepare(std::string sql) {
+  return Post([this, sql = std::move(sql)] {
+    auto state = std::make_unique<async_statement::state>();
+    state->statement.prepare(connection_, sql);
+    statements_.insert(state.get());
+    return async_statement{*this, state.release()};
+  });
+}
+
+void async_connection::Run() {
+  while (auto operation = queue_.wait_pop())
+    operation();
+
+  // Operations queued by the coroutines resumed by the last operations.
+  while (auto operation = queue_.try_pop()) {
+    if (*operation)
+      (*operation)();
+  }
+
+  // The statements outliving the connection.
+  for (auto* state : statements_)
+    delete state;
+  statements_.clear();
+
+  connection_ = connection{};
+}
+
+}  // namespace sql
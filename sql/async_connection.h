@@ -0,0 +1,214 @@
+#pragma once
+
+#include "sql/async_result.h"
+#include "sql/concurrent_queue.h"
+#include "sql/connection.h"
+#include "sql/statement.h"
+#include "sql/types.h"
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace sql {
+
+class async_connection;
+
+namespace internal {
+
+// Queued arguments own their strings.
+template <class T>
+struct stored_arg {
+  using type = T;
+};
+
+template <>
+struct stored_arg<const char*> {
+  using type = std::string;
+};
+
+template <>
+struct stored_arg<std::string_view> {
+  using type = std::string;
+};
+
+template <>
+struct stored_arg<const char16_t*> {
+  using type = std::u16string;
+};
+
+template <>
+struct stored_arg<std::u16string_view> {
+  using type = std::u16string;
+};
+
+template <class T>
+using stored_arg_t = typename stored_arg<std::decay_t<T>>::type;
+
+// Shared by an `async_connection` and its statements, so that the statements
+// outliving the connection do not queue operations after its worker stopped.
+struct connection_lifetime {
+  std::mutex mutex;
+  bool alive = true;
+};
+
+}  // namespace internal
+
+// A statement prepared by `async_connection::prepare`. The statement itself
+// lives on the worker thread and every call queues an operation for it.
+// May outlive the connection, but must not be used after it is destroyed.
+class async_statement {
+ public:
+  async_statement(async_statement&& source) noexcept
+      : connection_{std::exchange(source.connection_, nullptr)},
+        lifetime_{std::move(source.lifetime_)},
+        state_{std::exchange(source.state_, nullptr)} {}
+  async_statement& operator=(async_statement&& source) noexcept;
+
+  ~async_statement();
+
+  // Binds |args|, runs the statement and resets it.
+  template <class... Args>
+  async_result<void> execute(const Args&... args);
+
+  // Resets the statement and binds |args|. The next `fetch` starts reading
+  // the new rows.
+  template <class... Args>
+  async_result<void> bind_all(const Args&... args);
+
+  // Reads up to |max_rows| next rows. Returns an empty vector once the rows
+  // are exhausted. The rows must own their strings, as the statement moves on
+  // before they are taken.
+  template <class Row>
+  async_result<std::vector<Row>> fetch(size_t max_rows);
+
+ private:
+  // Accessed on the worker thread only.
+  struct state {
+    sql::statement statement;
+    // Set once `fetch` reaches the end of the rows.
+    bool done = false;
+  };
+
+  async_statement(async_connection& connection, state* state);
+
+  // Queues the deletion of the statement. The connection deletes the
+  // statements left when it is destroyed.
+  void Close();
+
+  async_connection* connection_;
+  std::shared_ptr<internal::connection_lifetime> lifetime_;
+  state* state_;
+
+  friend class async_connection;
+};
+
+// Owns a `connection` used exclusively by a dedicated worker thread, so that
+// the callers, e.g. event loop threads, never block on the driver. The
+// operations are queued through a lock-free queue and run in order. Their
+// results are waited on or awaited by coroutines, which resume on the worker
+// thread.
+class async_connection {
+ public:
+  async_connection();
+  // Runs the queued operations and closes the connection.
+  ~async_connection();
+
+  async_connection(const async_connection&) = delete;
+  async_connection& operator=(const async_connection&) = delete;
+
+  async_result<void> open(open_params params);
+  async_result<void> close();
+
+  async_result<void> query(std::string sql);
+
+  async_result<async_statement> prepare(std::string sql);
+
+  // Runs |f| with the connection on the worker thread and returns its result.
+  template <class F>
+  async_result<std::invoke_result_t<F&, connection&>> submit(F f) {
+    return Post([this, f = std::move(f)]() mutable { return f(connection_); });
+  }
+
+ private:
+  template <class F>
+  async_result<std::invoke_result_t<F&>> Post(F f) {
+    using R = std::invoke_result_t<F&>;
+    auto state = std::make_shared<internal::async_state<R>>();
+    queue_.push([state, f = std::move(f)]() mutable { state->run(f); });
+    return async_result<R>{std::move(state)};
+  }
+
+  void Run();
+
+  // Accessed on the worker thread only.
+  connection connection_;
+  std::unordered_set<async_statement::state*> statements_;
+
+  const std::shared_ptr<internal::connection_lifetime> lifetime_ =
+      std::make_shared<internal::connection_lifetime>();
+
+  // Empty operation stops the worker.
+  concurrent_queue<std::function<void()>> queue_;
+
+  std::thread thread_;
+
+  friend class async_statement;
+};
+
+template <class... Args>
+async_result<void> async_statement::execute(const Args&... args) {
+  return connection_->Post(
+      [state = state_,
+       args = std::tuple<internal::stored_arg_t<Args>...>{args...}] {
+        std::apply(
+            [state](const auto&... args) {
+              state->statement.execute(args...);
+            },
+            args);
+      });
+}
+
+template <class... Args>
+async_result<void> async_statement::bind_all(const Args&... args) {
+  return connection_->Post(
+      [state = state_,
+       args = std::tuple<internal::stored_arg_t<Args>...>{args...}] {
+        state->statement.reset();
+        state->done = false;
+        std::apply(
+            [state](const auto&... args) {
+              state->statement.bind_all(args...);
+            },
+            args);
+      });
+}
+
+template <class Row>
+async_result<std::vector<Row>> async_statement::fetch(size_t max_rows) {
+  static_assert(!internal::has_view_members_v<Row>,
+                "The rows must not hold views, which dangle once the "
+                "statement steps");
+  return connection_->Post([state = state_, max_rows] {
+    std::vector<Row> rows;
+    // SQLite restarts a finished statement on the next step.
+    while (!state->done && rows.size() < max_rows) {
+      if (!state->statement.next()) {
+        state->done = true;
+        break;
+      }
+      state->statement.read_row(rows.emplace_back());
+    }
+    return rows;
+  });
+}
+
+}  // namespace sql
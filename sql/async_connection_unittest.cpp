@@ -0,0 +1,119 @@
+#include "sql/async_connection.h"
+
+#include "sql/exception.h"
+#include "sql/test/temp_dir.h"
+
+#include <coroutine>
+#include <exception>
+#include <future>
+#include <optional>
+#include <gmock/gmock.h>
+
+using namespace testing;
+
+namespace sql {
+
+namespace {
+
+// Starts running on the calling thread and is never awaited.
+struct detached_task {
+  struct promise_type {
+    detached_task get_return_object() { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+  };
+};
+
+}  // namespace
+
+class AsyncConnectionTest : public Test {
+ public:
+  virtual void SetUp() override {
+    connection_.open({.path = temp_dir_.get() / "database.sqlite3"}).get();
+    connection_.query("CREATE TABLE t(x INTEGER, y TEXT)").get();
+  }
+
+ protected:
+  ScopedTempDir temp_dir_;
+  async_connection connection_;
+};
+
+TEST_F(AsyncConnectionTest, RunsOnWorkerThread) {
+  auto thread_id = connection_
+                       .submit([](connection& /*connection*/) {
+                         return std::this_thread::get_id();
+                       })
+                       .get();
+  EXPECT_NE(std::this_thread::get_id(), thread_id);
+}
+
+TEST_F(AsyncConnectionTest, ExecutesAndFetches) {
+  auto insert = connection_.prepare("INSERT INTO t VALUES(?, ?)").get();
+  std::vector<async_result<void>> inserts;
+  for (int i = 1; i <= 3; ++i)
+    inserts.emplace_back(insert.execute(i, std::to_string(i)));
+  for (auto& result : inserts)
+    EXPECT_NO_THROW(result.get());
+
+  auto select = connection_.prepare("SELECT x, y FROM t WHERE x>=?").get();
+  select.bind_all(2).get();
+  using Row = std::tuple<int, std::string>;
+  EXPECT_THAT(select.fetch<Row>(1).get(), ElementsAre(Row{2, "2"}));
+  EXPECT_THAT(select.fetch<Row>(5).get(), ElementsAre(Row{3, "3"}));
+  EXPECT_THAT(select.fetch<Row>(5).get(), IsEmpty());
+
+  select.bind_all(1).get();
+  EXPECT_EQ(3u, select.fetch<Row>(5).get().size());
+}
+
+TEST_F(AsyncConnectionTest, PropagatesErrors) {
+  EXPECT_THROW(connection_.query("INSERT INTO missing VALUES(1)").get(),
+               Exception);
+  EXPECT_THROW(connection_.prepare("SELECT FROM").get(), Exception);
+}
+
+TEST_F(AsyncConnectionTest, AwaitsFromCoroutine) {
+  std::promise<std::vector<std::tuple<int>>> promise;
+
+  [](async_connection& connection,
+     std::promise<std::vector<std::tuple<int>>>& promise) -> detached_task {
+    try {
+      co_await connection.query("INSERT INTO t VALUES(1, 'a'), (2, 'b')");
+      auto select = co_await connection.prepare("SELECT x FROM t ORDER BY x");
+      promise.set_value(co_await select.fetch<std::tuple<int>>(10));
+    } catch (...) {
+      promise.set_exception(std::current_exception());
+    }
+  }(connection_, promise);
+
+  EXPECT_THAT(promise.get_future().get(),
+              ElementsAre(std::tuple{1}, std::tuple{2}));
+}
+
+TEST_F(AsyncConnectionTest, MoveAssignsStatement) {
+  async_connection other;
+  other.open({.path = temp_dir_.get() / "other.sqlite3"}).get();
+
+  auto a = connection_.prepare("SELECT 1").get();
+  auto b = std::move(a);
+  a = other.prepare("SELECT 2").get();
+  b = other.prepare("SELECT 3").get();
+
+  using Row = std::tuple<int>;
+  EXPECT_THAT(a.fetch<Row>(5).get(), ElementsAre(Row{2}));
+  EXPECT_THAT(b.fetch<Row>(5).get(), ElementsAre(Row{3}));
+}
+
+TEST_F(AsyncConnectionTest, StatementOutlivesConnection) {
+  std::optional<async_statement> select;
+  {
+    async_connection connection;
+    connection.open({.path = temp_dir_.get() / "other.sqlite3"}).get();
+    select.emplace(connection.prepare("SELECT 1").get());
+  }
+  select.reset();
+}
+
+}  // namespace sql
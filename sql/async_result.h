@@ -0,0 +1,121 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace sql {
+
+namespace internal {
+
+// The state shared by an `async_result` and the thread that completes it.
+// Holds at most one awaiting coroutine, which is resumed on the completing
+// thread.
+template <class T>
+class async_state {
+ public:
+  using value_type = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+  // Runs |f| and completes the state with its result or exception.
+  template <class F>
+  void run(F& f) {
+    try {
+      if constexpr (std::is_void_v<T>) {
+        f();
+        value_.emplace();
+      } else {
+        value_.emplace(f());
+      }
+    } catch (...) {
+      error_ = std::current_exception();
+    }
+    Complete();
+  }
+
+  bool is_ready() const {
+    return state_.load(std::memory_order_acquire) == DONE;
+  }
+
+  void wait() const {
+    for (;;) {
+      auto state = state_.load(std::memory_order_acquire);
+      if (state == DONE)
+        return;
+      state_.wait(state, std::memory_order_acquire);
+    }
+  }
+
+  // Returns false if the state is already complete, so the coroutine must not
+  // be suspended.
+  bool suspend(std::coroutine_handle<> continuation) {
+    continuation_ = continuation;
+    int expected = PENDING;
+    return state_.compare_exchange_strong(expected, AWAITING,
+                                          std::memory_order_acq_rel);
+  }
+
+  T take() {
+    assert(is_ready());
+    if (error_)
+      std::rethrow_exception(error_);
+    if constexpr (!std::is_void_v<T>)
+      return std::move(*value_);
+  }
+
+ private:
+  enum { PENDING, AWAITING, DONE };
+
+  void Complete() {
+    auto state = state_.exchange(DONE, std::memory_order_acq_rel);
+    state_.notify_all();
+    if (state == AWAITING)
+      continuation_.resume();
+  }
+
+  std::atomic<int> state_ = PENDING;
+  std::coroutine_handle<> continuation_;
+  std::optional<value_type> value_;
+  std::exception_ptr error_;
+};
+
+}  // namespace internal
+
+// The result of an operation completed on another thread. Can be waited on
+// like a future or awaited by a C++20 coroutine, which then resumes on the
+// completing thread. The result is taken once, with `get` or `co_await`.
+template <class T>
+class async_result {
+ public:
+  explicit async_result(std::shared_ptr<internal::async_state<T>> state)
+      : state_{std::move(state)} {}
+
+  async_result(async_result&&) = default;
+  async_result& operator=(async_result&&) = default;
+
+  bool is_ready() const { return state_->is_ready(); }
+  void wait() const { state_->wait(); }
+
+  // Waits for the result and returns it, or rethrows the exception of the
+  // operation.
+  T get() {
+    state_->wait();
+    return state_->take();
+  }
+
+  bool await_ready() const { return state_->is_ready(); }
+  bool await_suspend(std::coroutine_handle<> continuation) {
+    return state_->suspend(continuation);
+  }
+  T await_resume() { return state_->take(); }
+
+ private:
+  std::shared_ptr<internal::async_state<T>> state_;
+};
+
+}  // namespace sql
@@ -0,0 +1,205 @@
+#pragma once
+
+#include "sql/types.h"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace sql {
+
+namespace internal {
+
+// Allocates 64-byte aligned buffers, so vectorized kernels can use aligned
+// loads from the start of every column.
+template <class T>
+class aligned_allocator {
+ public:
+  using value_type = T;
+
+  static constexpr std::align_val_t alignment{64};
+
+  aligned_allocator() = default;
+  template <class U>
+  aligned_allocator(const aligned_allocator<U>&) {}
+
+  T* allocate(size_t n) {
+    return static_cast<T*>(::operator new(n * sizeof(T), alignment));
+  }
+  void deallocate(T* p, size_t n) {
+    ::operator delete(p, n * sizeof(T), alignment);
+  }
+
+  template <class U>
+  bool operator==(const aligned_allocator<U>&) const {
+    return true;
+  }
+};
+
+template <class T>
+using aligned_vector = std::vector<T, aligned_allocator<T>>;
+
+}  // namespace internal
+
+// A single column of a `column_batch`. Values are stored in the array
+// matching |type()|: `INTEGER` in |integers()|, `FLOAT` in |floats()|, `TEXT`
+// and `BLOB` as |offsets()| into |bytes()|, with value `i` spanning
+// `[offsets[i], offsets[i + 1])`. NULL values take a zero or an empty slot.
+// The layout matches Arrow: |validity()| has bit `i % 8` of byte `i / 8` set
+// for non-NULL values.
+//
+// The type is taken from the declared type of the column if the driver knows
+// it, otherwise from the first non-NULL value, and is kept for the following
+// batches. Other values are converted to it. A column of NULLs only and
+// without a known type is `EMPTY`.
+class column_vector {
+ public:
+  field_type type() const { return type_; }
+  size_t size() const { return size_; }
+  size_t null_count() const { return null_count_; }
+
+  bool is_null(size_t index) const {
+    assert(index < size_);
+    return !(validity_[index / 8] & (1u << (index % 8)));
+  }
+
+  std::span<const int64_t> integers() const { return integers_; }
+  std::span<const double> floats() const { return floats_; }
+  std::span<const int32_t> offsets() const { return offsets_; }
+  std::span<const char> bytes() const { return bytes_; }
+  std::span<const uint8_t> validity() const { return validity_; }
+
+  std::string_view string_at(size_t index) const {
+    assert(index < size_);
+    return {bytes_.data() + offsets_[index],
+            static_cast<size_t>(offsets_[index + 1] - offsets_[index])};
+  }
+
+  // Used by the drivers.
+
+  // Empties the column, but keeps its type and buffers.
+  void clear() {
+    size_ = 0;
+    null_count_ = 0;
+    integers_.clear();
+    floats_.clear();
+    offsets_.assign(1, 0);
+    bytes_.clear();
+    validity_.clear();
+  }
+
+  // Sets the type of an `EMPTY` column, which may already hold NULLs.
+  void set_type(field_type type) {
+    assert(type_ == field_type::EMPTY);
+    type_ = type;
+    switch (type_) {
+      case field_type::INTEGER:
+        integers_.resize(size_);
+        break;
+      case field_type::FLOAT:
+        floats_.resize(size_);
+        break;
+      case field_type::TEXT:
+      case field_type::BLOB:
+        offsets_.resize(size_ + 1);
+        break;
+      case field_type::EMPTY:
+        break;
+    }
+  }
+
+  void append_null() {
+    switch (type_) {
+      case field_type::INTEGER:
+        integers_.push_back(0);
+        break;
+      case field_type::FLOAT:
+        floats_.push_back(0);
+        break;
+      case field_type::TEXT:
+      case field_type::BLOB:
+        offsets_.push_back(offsets_.back());
+        break;
+      case field_type::EMPTY:
+        break;
+    }
+    ++null_count_;
+    AppendValidity(false);
+  }
+
+  void append_integer(int64_t value) {
+    assert(type_ == field_type::INTEGER);
+    integers_.push_back(value);
+    AppendValidity(true);
+  }
+
+  void append_float(double value) {
+    assert(type_ == field_type::FLOAT);
+    floats_.push_back(value);
+    AppendValidity(true);
+  }
+
+  void append_string(std::string_view value) {
+    assert(type_ == field_type::TEXT || type_ == field_type::BLOB);
+    bytes_.insert(bytes_.end(), value.begin(), value.end());
+    offsets_.push_back(static_cast<int32_t>(bytes_.size()));
+    AppendValidity(true);
+  }
+
+ private:
+  void AppendValidity(bool valid) {
+    if (size_ % 8 == 0)
+      validity_.push_back(0);
+    if (valid)
+      validity_.back() |= static_cast<uint8_t>(1u << (size_ % 8));
+    ++size_;
+  }
+
+  field_type type_ = field_type::EMPTY;
+  size_t size_ = 0;
+  size_t null_count_ = 0;
+
+  internal::aligned_vector<int64_t> integers_;
+  internal::aligned_vector<double> floats_;
+  internal::aligned_vector<int32_t> offsets_ =
+      internal::aligned_vector<int32_t>(1);
+  internal::aligned_vector<char> bytes_;
+  internal::aligned_vector<uint8_t> validity_;
+};
+
+// Rows of a result set stored by column, filled by `statement::fetch_batch`.
+// Reuse the same batch for the following fetches of a statement to reuse its
+// buffers and column types.
+class column_batch {
+ public:
+  size_t row_count() const { return row_count_; }
+  size_t column_count() const { return columns_.size(); }
+
+  const column_vector& column(size_t index) const { return columns_[index]; }
+  std::span<const column_vector> columns() const { return columns_; }
+
+  // Used by the drivers.
+
+  // Empties the batch. The column types are reset if |column_count| differs.
+  void clear(size_t column_count) {
+    if (columns_.size() != column_count)
+      columns_ = std::vector<column_vector>(column_count);
+    for (auto& column : columns_)
+      column.clear();
+    row_count_ = 0;
+  }
+
+  column_vector& column(size_t index) { return columns_[index]; }
+
+  void end_row() { ++row_count_; }
+
+ private:
+  std::vector<column_vector> columns_;
+  size_t row_count_ = 0;
+};
+
+}  // namespace sql
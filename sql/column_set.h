@@ -0,0 +1,46 @@
+#pragma once
+
+#include "sql/types.h"
+
+#include <optional>
+#include <span>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace sql {
+
+// Result column descriptors of a statement with a hashed name lookup. With
+// duplicate names, the first column wins.
+class column_set {
+ public:
+  column_set() = default;
+
+  explicit column_set(std::vector<column_info> columns)
+      : columns_{std::move(columns)} {
+    index_.reserve(columns_.size());
+    for (unsigned i = 0; i < columns_.size(); ++i)
+      index_.try_emplace(columns_[i].name, i);
+  }
+
+  // The names in |index_| point into |columns_|.
+  column_set(const column_set&) = delete;
+  column_set& operator=(const column_set&) = delete;
+  column_set(column_set&&) = default;
+  column_set& operator=(column_set&&) = default;
+
+  size_t size() const { return columns_.size(); }
+  std::span<const column_info> get() const { return columns_; }
+
+  std::optional<unsigned> find(std::string_view name) const {
+    auto i = index_.find(name);
+    return i != index_.end() ? std::optional{i->second} : std::nullopt;
+  }
+
+ private:
+  std::vector<column_info> columns_;
+  std::unordered_map<std::string_view, unsigned> index_;
+};
+
+}  // namespace sql
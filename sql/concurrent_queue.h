@@ -0,0 +1,78 @@
+#pragma once
+
+#include <boost/lockfree/queue.hpp>
+#include <cassert>
+#include <chrono>
+#include <memory>
+#include <new>
+#include <optional>
+#include <semaphore>
+
+namespace sql {
+
+// Multi-producer, multi-consumer queue. `push` and `try_pop` are lock-free;
+// `wait_pop` and `wait_pop_until` block on a semaphore counting the items.
+template <class T>
+class concurrent_queue {
+ public:
+  // Preallocates |capacity| nodes. The queue grows beyond it as needed.
+  explicit concurrent_queue(size_t capacity = 1024) : queue_{capacity} {}
+
+  ~concurrent_queue() {
+    T* item = nullptr;
+    while (queue_.pop(item))
+      delete item;
+  }
+
+  concurrent_queue(const concurrent_queue&) = delete;
+  concurrent_queue& operator=(const concurrent_queue&) = delete;
+
+  // Throws `std::bad_alloc` if no node can be allocated.
+  void push(T value) {
+    auto item = std::make_unique<T>(std::move(value));
+    if (!queue_.push(item.get()))
+      throw std::bad_alloc{};
+    item.release();
+    items_.release();
+  }
+
+  std::optional<T> try_pop() {
+    if (!items_.try_acquire())
+      return std::nullopt;
+    return Pop();
+  }
+
+  T wait_pop() {
+    items_.acquire();
+    return Pop();
+  }
+
+  // Returns an empty optional if no item is pushed by |deadline|.
+  template <class Clock, class Duration>
+  std::optional<T> wait_pop_until(
+      const std::chrono::time_point<Clock, Duration>& deadline) {
+    if (!items_.try_acquire_until(deadline))
+      return std::nullopt;
+    return Pop();
+  }
+
+  // Advisory only: the result may be stale by the time it is returned when
+  // other threads push or pop concurrently.
+  bool empty() const { return queue_.empty(); }
+
+ private:
+  // Pops the item whose count was taken from |items_|.
+  T Pop() {
+    T* item = nullptr;
+    [[maybe_unused]] bool popped = queue_.pop(item);
+    assert(popped);
+    std::unique_ptr<T> holder{item};
+    return std::move(*holder);
+  }
+
+  boost::lockfree::queue<T*> queue_;
+  // Released after the push, so an acquired count guarantees an item.
+  std::counting_semaphore<> items_{0};
+};
+
+}  // namespace sql
@@ -1,9 +1,14 @@
 #include "sql/connection.h"
 
+#if !defined(SQL_SINGLE_BACKEND_SQLITE3)
 #include "sql/postgresql/connection.h"
 #include "sql/postgresql/statement.h"
+#endif
+
+#if !defined(SQL_SINGLE_BACKEND_POSTGRESQL)
 #include "sql/sqlite3/connection.h"
 #include "sql/sqlite3/statement.h"
+#endif
 
 #include <cassert>
 
@@ -22,14 +27,35 @@ class connection::connection_model_impl : public connection_model {
 
   virtual void start() override { connection_.start(); }
 
+  virtual void start(const transaction_options& options) override {
+    connection_.start(options);
+  }
+
   virtual void commit() override { connection_.commit(); }
 
   virtual void rollback() override { connection_.rollback(); }
 
+  virtual void savepoint(std::string_view name) override {
+    connection_.savepoint(name);
+  }
+
+  virtual void release_savepoint(std::string_view name) override {
+    connection_.release_savepoint(name);
+  }
+
+  virtual void rollback_to_savepoint(std::string_view name) override {
+    connection_.rollback_to_savepoint(name);
+  }
+
   virtual int last_change_count() const override {
     return connection_.last_change_count();
   }
 
+  virtual std::string key_set_sql(std::string_view sql,
+                                  size_t key_count) const override {
+    return connection_.key_set_sql(sql, key_count);
+  }
+
   virtual bool table_exists(std::string_view table_name) const override {
     return connection_.table_exists(table_name);
   }
@@ -107,10 +133,32 @@ class connection::statement_model_impl : public statement_model {
     statement_.bind(column, value);
   }
 
+  virtual void bind_params(std::span<const param_value> params) override {
+    statement_.bind_params(params);
+  }
+
+  virtual void bind_key_set(std::span<const param_value> keys) override {
+    statement_.bind_key_set(keys);
+  }
+
+  virtual int64_t execute_batch(std::span<const param_value> params,
+                                size_t row_count) override {
+    return statement_.execute_batch(params, row_count);
+  }
+
   virtual size_t field_count() const override {
     return statement_.field_count();
   }
 
+  virtual std::span<const column_info> columns() const override {
+    return statement_.columns();
+  }
+
+  virtual std::optional<unsigned> find_column(
+      std::string_view name) const override {
+    return statement_.find_column(name);
+  }
+
   virtual sql::field_type type(unsigned column) const override {
     return statement_.type(column);
   }
@@ -143,11 +191,22 @@ class connection::statement_model_impl : public statement_model {
     return statement_.at(column).as_string16();
   }
 
+  virtual void read_fields(
+      std::span<const column_target> targets) const override {
+    statement_.read_fields(targets);
+  }
+
   virtual void query() override { statement_.query(); }
   virtual bool next() override { return statement_.next(); }
   virtual void reset() override { statement_.reset(); }
+
+  virtual size_t fetch_batch(column_batch& batch, size_t max_rows) override {
+    return statement_.fetch_batch(batch, max_rows);
+  }
   virtual void close() override { statement_.close(); }
 
+  virtual query_plan explain() const override { return statement_.explain(); }
+
  private:
   StatementType statement_;
 };
@@ -159,16 +218,23 @@ connection::connection(const open_params& params) {
 void connection::open(const open_params& params) {
   assert(!model_);
 
+#if !defined(SQL_SINGLE_BACKEND_POSTGRESQL)
   if (params.driver.empty() || params.driver == "sqlite" ||
       params.driver == "sqlite3") {
     model_ = std::make_unique<
         connection_model_impl<sqlite3::connection, sqlite3::statement>>();
-  } else if (params.driver == "postgres" || params.driver == "postgresql") {
+  }
+#endif
+
+#if !defined(SQL_SINGLE_BACKEND_SQLITE3)
+  if (params.driver == "postgres" || params.driver == "postgresql") {
     model_ = std::make_unique<
         connection_model_impl<postgresql::connection, postgresql::statement>>();
-  } else {
-    throw std::runtime_error{"Unknown SQL driver"};
   }
+#endif
+
+  if (!model_)
+    throw std::runtime_error{"Unknown SQL driver"};
 
   model_->open(params);
 }
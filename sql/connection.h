@@ -1,8 +1,16 @@
 #pragma once
 
+#include "sql/column_batch.h"
+#include "sql/fetch_many.h"
+#include "sql/param.h"
+#include "sql/query_range.h"
+#include "sql/row.h"
 #include "sql/types.h"
 
 #include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
 #include <vector>
 
 namespace sql {
@@ -31,10 +39,41 @@ class connection {
 
   void query(std::string_view sql) { model_->query(sql); }
 
+  // Runs |sql| with |args| bound to its parameters and returns an input range
+  // of |Row|s. See `query_range`.
+  template <class Row, class... Args>
+  query_range<Row, statement> query(std::string_view sql,
+                                    const Args&... args) {
+    return {*this, sql, args...};
+  }
+
+  // Looks up the rows of |keys| with one set-based query per chunk of keys and
+  // returns them by key. |sql| selects the key as the first member of |Row|
+  // and filters it with `IN (?)`, its only parameter. See `fetch_many`.
+  template <class Row, std::ranges::input_range Keys>
+  auto fetch_many(std::string_view sql, Keys&& keys) {
+    return sql::internal::fetch_many<Row>(*this, sql, keys);
+  }
+
+  // Rewrites the `IN (?)` key set placeholder of |sql| for |key_count| keys
+  // bound with `statement::bind_key_set`.
+  std::string key_set_sql(std::string_view sql, size_t key_count) const {
+    return model_->key_set_sql(sql, key_count);
+  }
+
   void start() { model_->start(); }
+  void start(const transaction_options& options) { model_->start(options); }
   void commit() { model_->commit(); }
   void rollback() { model_->rollback(); }
 
+  void savepoint(std::string_view name) { model_->savepoint(name); }
+  void release_savepoint(std::string_view name) {
+    model_->release_savepoint(name);
+  }
+  void rollback_to_savepoint(std::string_view name) {
+    model_->rollback_to_savepoint(name);
+  }
+
   int last_change_count() const { return model_->last_change_count(); }
 
   bool table_exists(std::string_view table_name) const {
@@ -69,8 +108,15 @@ class connection {
     virtual void bind(unsigned column, const char16_t* value) = 0;
     virtual void bind(unsigned column, std::string_view value) = 0;
     virtual void bind(unsigned column, std::u16string_view value) = 0;
+    virtual void bind_params(std::span<const param_value> params) = 0;
+    virtual void bind_key_set(std::span<const param_value> keys) = 0;
+    virtual int64_t execute_batch(std::span<const param_value> params,
+                                  size_t row_count) = 0;
 
     virtual size_t field_count() const = 0;
+    virtual std::span<const column_info> columns() const = 0;
+    virtual std::optional<unsigned> find_column(
+        std::string_view name) const = 0;
     virtual field_type type(unsigned column) const = 0;
 
     virtual bool as_bool(unsigned column) const = 0;
@@ -81,11 +127,17 @@ class connection {
     virtual std::string as_string(unsigned column) const = 0;
     virtual std::u16string as_string16(unsigned column) const = 0;
 
+    virtual void read_fields(std::span<const column_target> targets) const = 0;
+
     virtual void query() = 0;
     virtual bool next() = 0;
     virtual void reset() = 0;
 
+    virtual size_t fetch_batch(column_batch& batch, size_t max_rows) = 0;
+
     virtual void close() = 0;
+
+    virtual query_plan explain() const = 0;
   };
 
   class connection_model {
@@ -98,11 +150,19 @@ class connection {
     virtual void query(std::string_view sql) = 0;
 
     virtual void start() = 0;
+    virtual void start(const transaction_options& options) = 0;
     virtual void commit() = 0;
     virtual void rollback() = 0;
 
+    virtual void savepoint(std::string_view name) = 0;
+    virtual void release_savepoint(std::string_view name) = 0;
+    virtual void rollback_to_savepoint(std::string_view name) = 0;
+
     virtual int last_change_count() const = 0;
 
+    virtual std::string key_set_sql(std::string_view sql,
+                                    size_t key_count) const = 0;
+
     virtual bool table_exists(std::string_view table_name) const = 0;
     virtual bool field_exists(std::string_view table_name,
                               std::string_view column_name) const = 0;
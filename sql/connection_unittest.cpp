@@ -1,15 +1,14 @@
 #include "sql/connection.h"
-#include "sql/postgresql/connection.h"
-#include "sql/postgresql/statement.h"
-#include "sql/sqlite3/connection.h"
-#include "sql/sqlite3/statement.h"
 #include "sql/statement.h"
+#include "sql/static_connection.h"
 #include "sql/test/temp_dir.h"
+#include "sql/transaction.h"
 
 #include <filesystem>
 #include <format>
 #include <gmock/gmock.h>
 #include <random>
+#include <ranges>
 #include <span>
 
 using namespace testing;
@@ -19,6 +18,7 @@ namespace sql {
 template <class T>
 struct connection_traits;
 
+#if !defined(SQL_SINGLE_BACKEND_POSTGRESQL)
 template <>
 struct connection_traits<sql::sqlite3::connection> {
   sql::open_params GetOpenParams() {
@@ -27,7 +27,9 @@ struct connection_traits<sql::sqlite3::connection> {
 
   ScopedTempDir temp_dir_;
 };
+#endif
 
+#if !defined(SQL_SINGLE_BACKEND_SQLITE3)
 template <>
 struct connection_traits<sql::postgresql::connection> {
   sql::open_params GetOpenParams() {
@@ -37,10 +39,21 @@ struct connection_traits<sql::postgresql::connection> {
             "host=localhost port=5433 dbname=test user=postgres password=1234"};
   }
 };
+#endif
+
+#if defined(SQL_SINGLE_BACKEND_POSTGRESQL)
+using default_connection = sql::postgresql::connection;
+#else
+using default_connection = sql::sqlite3::connection;
+#endif
 
 template <>
 struct connection_traits<sql::connection>
-    : connection_traits<sql::sqlite3::connection> {};
+    : connection_traits<default_connection> {};
+
+template <>
+struct connection_traits<sql::static_connection>
+    : connection_traits<default_connection> {};
 
 struct Row {
   int a;
@@ -71,9 +84,20 @@ class ConnectionTest : public Test {
   std::string table_name_;
 };
 
+#if defined(SQL_SINGLE_BACKEND_SQLITE3)
 using connection_types = ::testing::Types<sql::connection,
                                           sql::sqlite3::connection,
-                                          sql::postgresql::connection>;
+                                          sql::static_connection>;
+#elif defined(SQL_SINGLE_BACKEND_POSTGRESQL)
+using connection_types = ::testing::Types<sql::connection,
+                                          sql::postgresql::connection,
+                                          sql::static_connection>;
+#else
+using connection_types = ::testing::Types<sql::connection,
+                                          sql::sqlite3::connection,
+                                          sql::postgresql::connection,
+                                          sql::static_connection>;
+#endif
 TYPED_TEST_SUITE(ConnectionTest, connection_types);
 
 std::vector<Row> GenerateRows() {
@@ -164,6 +188,13 @@ void ConnectionTest<T>::InsertTestData(std::span<const Row> rows) {
   }
 }
 
+// gMock container matchers require `const_iterator`, which `std::span` lacks
+// before C++23.
+template <class T>
+std::vector<T> ToVector(std::span<const T> span) {
+  return {span.begin(), span.end()};
+}
+
 template <class T>
 std::vector<Row> ReadAllRows(T& statement) {
   std::vector<Row> rows;
@@ -183,6 +214,16 @@ std::vector<Row> ReadAllRows(T& statement) {
   return rows;
 }
 
+template <class T>
+int64_t CountRows(T& connection, std::string_view table_name) {
+  typename T::statement statement{
+      connection, std::format("SELECT COUNT(*) FROM {}", table_name)};
+  EXPECT_TRUE(statement.next());
+  auto count = statement.at(0).as_int64();
+  statement.reset();
+  return count;
+}
+
 TYPED_TEST(ConnectionTest, TestStatements) {
   const auto& table_name = this->table_name_;
 
@@ -231,4 +272,309 @@ TYPED_TEST(ConnectionTest, ParametrizedStatement) {
   EXPECT_THAT(ReadAllRows(statement), ElementsAre(Row{10, 100, "A"}));
 }
 
+TYPED_TEST(ConnectionTest, BindsEmptyString) {
+  using StatementType = TypeParam::statement;
+
+  StatementType insert{
+      this->connection_,
+      std::format("INSERT INTO {} VALUES(?, ?, ?)", this->table_name_)};
+  insert.bind(0, 1);
+  insert.bind(1, 1);
+  insert.bind(2, "");
+  insert.query();
+
+  StatementType select{
+      this->connection_,
+      std::format("SELECT COUNT(*) FROM {} WHERE c=''", this->table_name_)};
+  ASSERT_TRUE(select.next());
+  EXPECT_EQ(select.at(0).as_int64(), 1);
+}
+
+TYPED_TEST(ConnectionTest, ReadRow) {
+  const auto& table_name = this->table_name_;
+
+  auto initial_rows = GenerateRows();
+  this->InsertTestData(initial_rows);
+  this->connection_.query(
+      std::format("INSERT INTO {} VALUES(40, NULL, NULL)", table_name));
+
+  using ConnectionType = TypeParam;
+  using StatementType = ConnectionType::statement;
+
+  StatementType statement{this->connection_,
+                          std::format("SELECT * FROM {} ORDER BY a",
+                                      table_name)};
+
+  std::vector<Row> rows;
+  for (size_t i = 0; i < initial_rows.size(); ++i) {
+    ASSERT_TRUE(statement.next());
+    statement.read_row(rows.emplace_back());
+  }
+  EXPECT_THAT(rows, ElementsAreArray(initial_rows));
+
+  ASSERT_TRUE(statement.next());
+  EXPECT_EQ(std::make_tuple(40, std::optional<int64_t>{},
+                            std::optional<std::string>{}),
+            (statement.template read_row<int, std::optional<int64_t>,
+                                         std::optional<std::string>>()));
+
+  Row row{1, 2, "C"};
+  statement.read_row(row);
+  EXPECT_EQ((Row{40, 0, ""}), row);
+
+  EXPECT_FALSE(statement.next());
+}
+
+TYPED_TEST(ConnectionTest, QueryRange) {
+  using ConnectionType = TypeParam;
+  static_assert(std::ranges::input_range<
+                query_range<Row, typename ConnectionType::statement>>);
+
+  const auto& table_name = this->table_name_;
+
+  auto initial_rows = GenerateRows();
+  this->InsertTestData(initial_rows);
+
+  std::vector<Row> rows;
+  for (auto& row : this->connection_.template query<Row>(
+           std::format("SELECT * FROM {} WHERE a >= ? ORDER BY a", table_name),
+           20)) {
+    rows.emplace_back(std::move(row));
+  }
+  EXPECT_THAT(rows, ElementsAre(initial_rows[1], initial_rows[2]));
+
+  std::vector<std::tuple<std::string, std::optional<int64_t>>> tuples;
+  for (auto& row :
+       this->connection_
+           .template query<std::tuple<std::string, std::optional<int64_t>>>(
+               std::format("SELECT c, b FROM {} WHERE c = ?", table_name),
+               std::optional<std::string_view>{"A"})) {
+    tuples.emplace_back(row);
+  }
+  EXPECT_THAT(tuples, ElementsAre(FieldsAre("A", 100)));
+
+  auto empty = this->connection_.template query<Row>(
+      std::format("SELECT * FROM {} WHERE c IS ?", table_name),
+      std::optional<std::string_view>{});
+  EXPECT_TRUE(empty.begin() == empty.end());
+}
+
+TYPED_TEST(ConnectionTest, BindAll) {
+  const auto& table_name = this->table_name_;
+
+  using ConnectionType = TypeParam;
+  using StatementType = ConnectionType::statement;
+
+  StatementType insert{
+      this->connection_,
+      std::format("INSERT INTO {} VALUES(?, ?, ?)", table_name)};
+  auto initial_rows = GenerateRows();
+  for (const auto& row : initial_rows) {
+    insert.execute(row.a, row.b, row.c);
+    EXPECT_EQ(1, this->connection_.last_change_count());
+  }
+  insert.execute(40, std::optional<int64_t>{}, std::nullopt);
+
+  StatementType statement{
+      this->connection_,
+      std::format("SELECT * FROM {} WHERE a=? AND b=? AND c=?", table_name)};
+  statement.bind_all(20, int64_t{200}, "B");
+  EXPECT_THAT(ReadAllRows(statement), ElementsAre(initial_rows[1]));
+
+  EXPECT_EQ(4, CountRows(this->connection_, table_name));
+}
+
+TYPED_TEST(ConnectionTest, ExecuteBatch) {
+  const auto& table_name = this->table_name_;
+
+  using ConnectionType = TypeParam;
+  using StatementType = ConnectionType::statement;
+
+  StatementType insert{
+      this->connection_,
+      std::format("INSERT INTO {} VALUES(?, ?, ?)", table_name)};
+  auto initial_rows = GenerateRows();
+  EXPECT_THAT(insert.execute_batch(initial_rows), ElementsAre(3));
+  const std::vector<std::tuple<int, std::optional<int64_t>, const char*>>
+      null_rows{{40, std::nullopt, "D"}};
+  EXPECT_THAT(insert.execute_batch(null_rows), ElementsAre(1));
+
+  StatementType update{
+      this->connection_,
+      std::format("UPDATE {} SET c=? WHERE a<=?", table_name)};
+  const std::vector<std::tuple<const char*, int>> updates{{"X", 20},
+                                                          {"Y", 100}};
+  EXPECT_THAT(update.execute_batch(updates), ElementsAre(6));
+
+  StatementType select{
+      this->connection_,
+      std::format("SELECT COUNT(*) FROM {} WHERE c='Y'", table_name)};
+  ASSERT_TRUE(select.next());
+  EXPECT_EQ(4, select.at(0).as_int64());
+
+  // One count per driver call.
+  std::vector<std::tuple<int, int64_t, const char*>> many_rows(
+      internal::kBatchRowCount + 2, {1000, 1, "Z"});
+  EXPECT_THAT(insert.execute_batch(many_rows),
+              ElementsAre(internal::kBatchRowCount, 2));
+}
+
+TYPED_TEST(ConnectionTest, FetchMany) {
+  const auto& table_name = this->table_name_;
+
+  auto initial_rows = GenerateRows();
+  this->InsertTestData(initial_rows);
+
+  auto rows = this->connection_.template fetch_many<Row>(
+      std::format("SELECT * FROM {} WHERE a IN (?)", table_name),
+      std::vector<int>{30, 10, 50, 10});
+  EXPECT_THAT(rows, UnorderedElementsAre(Pair(10, initial_rows[0]),
+                                         Pair(30, initial_rows[2])));
+
+  std::vector<std::string> keys;
+  for (int i = 0; i < 1000; ++i)
+    keys.push_back(std::string(1, static_cast<char>('A' + i % 26)));
+  auto rows_by_c = this->connection_.template fetch_many<
+      std::tuple<std::string, int>>(
+      std::format("SELECT c, a FROM {} WHERE c IN (?)", table_name), keys);
+  EXPECT_THAT(rows_by_c, UnorderedElementsAre(Pair("A", std::tuple{"A", 10}),
+                                              Pair("B", std::tuple{"B", 20}),
+                                              Pair("C", std::tuple{"C", 30})));
+
+  EXPECT_TRUE(this->connection_.template fetch_many<Row>(
+                  std::format("SELECT * FROM {} WHERE a IN (?)", table_name),
+                  std::vector<int>{})
+                  .empty());
+}
+
+TYPED_TEST(ConnectionTest, FetchBatch) {
+  const auto& table_name = this->table_name_;
+
+  auto initial_rows = GenerateRows();
+  this->InsertTestData(initial_rows);
+  this->connection_.query(
+      std::format("INSERT INTO {} VALUES(40, NULL, NULL)", table_name));
+
+  using ConnectionType = TypeParam;
+  using StatementType = ConnectionType::statement;
+
+  StatementType statement{this->connection_,
+                          std::format("SELECT * FROM {} ORDER BY a",
+                                      table_name)};
+
+  column_batch batch;
+  ASSERT_EQ(2u, statement.fetch_batch(batch, 2));
+  ASSERT_EQ(3u, batch.column_count());
+  EXPECT_EQ(field_type::INTEGER, batch.column(0).type());
+  EXPECT_THAT(ToVector(batch.column(0).integers()), ElementsAre(10, 20));
+  EXPECT_THAT(ToVector(batch.column(1).integers()), ElementsAre(100, 200));
+  EXPECT_EQ(field_type::TEXT, batch.column(2).type());
+  EXPECT_EQ("A", batch.column(2).string_at(0));
+  EXPECT_EQ("B", batch.column(2).string_at(1));
+  EXPECT_EQ(0u, batch.column(2).null_count());
+
+  ASSERT_EQ(2u, statement.fetch_batch(batch, 2));
+  EXPECT_THAT(ToVector(batch.column(0).integers()), ElementsAre(30, 40));
+  EXPECT_THAT(ToVector(batch.column(1).integers()), ElementsAre(300, 0));
+  EXPECT_FALSE(batch.column(1).is_null(0));
+  EXPECT_TRUE(batch.column(1).is_null(1));
+  EXPECT_EQ(1u, batch.column(1).null_count());
+  EXPECT_THAT(ToVector(batch.column(1).validity()), ElementsAre(0b01));
+  EXPECT_EQ("C", batch.column(2).string_at(0));
+  EXPECT_EQ("", batch.column(2).string_at(1));
+  EXPECT_THAT(ToVector(batch.column(2).offsets()), ElementsAre(0, 1, 1));
+
+  EXPECT_EQ(0u, statement.fetch_batch(batch, 2));
+  EXPECT_EQ(0u, batch.row_count());
+}
+
+TYPED_TEST(ConnectionTest, Columns) {
+  using ConnectionType = TypeParam;
+  using StatementType = ConnectionType::statement;
+
+  StatementType statement{
+      this->connection_,
+      std::format("SELECT A AS x, B AS y, C AS z FROM {}", this->table_name_)};
+
+  EXPECT_EQ(3u, statement.field_count());
+  auto columns = statement.columns();
+  ASSERT_EQ(3u, columns.size());
+  EXPECT_EQ("x", columns[0].name);
+  EXPECT_EQ("y", columns[1].name);
+  EXPECT_EQ("z", columns[2].name);
+  EXPECT_EQ(1u, statement.find_column("y"));
+  EXPECT_EQ(std::nullopt, statement.find_column("missing"));
+}
+
+TYPED_TEST(ConnectionTest, Transaction) {
+  using TransactionType = basic_transaction<TypeParam>;
+
+  const auto& table_name = this->table_name_;
+  auto initial_rows = GenerateRows();
+
+  {
+    TransactionType transaction{this->connection_};
+    this->InsertTestData(initial_rows);
+    // Rolled back on destruction.
+  }
+  EXPECT_EQ(0, CountRows(this->connection_, table_name));
+
+  {
+    TransactionType transaction{this->connection_,
+                                {.mode = transaction_mode::IMMEDIATE,
+                                 .isolation = isolation_level::SERIALIZABLE}};
+    this->InsertTestData(initial_rows);
+    transaction.commit();
+  }
+  EXPECT_EQ(3, CountRows(this->connection_, table_name));
+}
+
+TYPED_TEST(ConnectionTest, NestedTransaction) {
+  using TransactionType = basic_transaction<TypeParam>;
+
+  const auto& table_name = this->table_name_;
+  auto initial_rows = GenerateRows();
+  std::span<const Row> rows{initial_rows};
+
+  TransactionType transaction{this->connection_};
+  this->InsertTestData(rows.subspan(0, 1));
+
+  {
+    TransactionType nested{transaction};
+    EXPECT_TRUE(nested.is_nested());
+    this->InsertTestData(rows.subspan(1, 1));
+    // Rolled back on destruction.
+  }
+  EXPECT_EQ(1, CountRows(this->connection_, table_name));
+
+  {
+    TransactionType nested{transaction};
+    this->InsertTestData(rows.subspan(2, 1));
+    {
+      TransactionType nested2{nested};
+      this->InsertTestData(rows.subspan(1, 1));
+      nested2.rollback();
+    }
+    nested.commit();
+  }
+
+  transaction.commit();
+  EXPECT_EQ(2, CountRows(this->connection_, table_name));
+}
+
+TYPED_TEST(ConnectionTest, Explain) {
+  const auto& table_name = this->table_name_;
+
+  using ConnectionType = TypeParam;
+  using StatementType = ConnectionType::statement;
+
+  StatementType statement{this->connection_,
+                          std::format("SELECT * FROM {} WHERE a=?", table_name)};
+  statement.bind(0, 10);
+
+  auto full_scans = statement.explain().full_scans();
+  ASSERT_EQ(1u, full_scans.size());
+  EXPECT_THAT(full_scans[0]->table, StrCaseEq(table_name));
+}
+
 }  // namespace sql
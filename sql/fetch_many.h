@@ -0,0 +1,91 @@
+#pragma once
+
+#include "sql/exception.h"
+#include "sql/param.h"
+#include "sql/row.h"
+
+#include <algorithm>
+#include <ranges>
+#include <span>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace sql {
+
+namespace internal {
+
+// The placeholder of the key set in the SQL passed to `fetch_many`.
+inline constexpr std::string_view kKeySetPlaceholder = "IN (?)";
+
+// The maximum number of keys looked up by a single query. Fits the oldest
+// SQLite parameter limit.
+inline constexpr size_t kKeySetChunkSize = 512;
+
+// Returns the position of `kKeySetPlaceholder` in |sql|.
+inline size_t FindKeySetPlaceholder(std::string_view sql) {
+  auto pos = sql.find(kKeySetPlaceholder);
+  if (pos == sql.npos) {
+    throw Exception{std::string{"Key set placeholder `"} +
+                    std::string{kKeySetPlaceholder} + "` not found"};
+  }
+  return pos;
+}
+
+// Looks up the rows of |keys| with a single query per chunk of keys. |sql|
+// filters the keys with `IN (?)`, its only parameter, and selects the key as
+// the first member of |Row|. Returns the rows by key; keys without rows are
+// absent. String keys are referenced until the last query, so they must not be
+// temporaries produced by the range.
+template <class Row, class Connection, std::ranges::input_range Keys>
+auto fetch_many(Connection& connection, std::string_view sql, Keys&& keys) {
+  using Key = std::ranges::range_value_t<Keys>;
+  static_assert(
+      std::is_lvalue_reference_v<std::ranges::range_reference_t<Keys>> ||
+          std::is_arithmetic_v<Key>,
+      "The string keys must outlive the queries, e.g. be stored in a "
+      "container, as they are bound by reference");
+  static_assert(!has_view_members_v<Row>,
+                "The rows must not hold views, which dangle once the "
+                "statement steps");
+
+  std::unordered_map<Key, Row> rows;
+
+  std::vector<param_value> params;
+  for (const auto& key : keys)
+    params.push_back(make_param(key));
+  if (params.empty())
+    return rows;
+
+  // Pads the last chunk with its last key, so that a single statement serves
+  // all chunks.
+  size_t chunk_size = std::min(params.size(), kKeySetChunkSize);
+  param_value last_param = params.back();
+  params.resize((params.size() + chunk_size - 1) / chunk_size * chunk_size,
+                last_param);
+
+  typename Connection::statement statement{
+      connection, connection.key_set_sql(sql, chunk_size)};
+
+  Row row;
+  auto targets = make_column_targets(row);
+  for (size_t i = 0; i < params.size(); i += chunk_size) {
+    statement.bind_key_set(std::span{params}.subspan(i, chunk_size));
+    while (statement.next()) {
+      statement.read_fields(targets);
+      Key key = static_cast<Key>(std::get<0>(tie_members(row)));
+      rows.insert_or_assign(std::move(key), row);
+    }
+    statement.reset();
+  }
+
+  return rows;
+}
+
+}  // namespace internal
+
+}  // namespace sql
@@ -0,0 +1,118 @@
+#include "sql/group_commit.h"
+
+#include "sql/connection.h"
+#include "sql/transaction.h"
+
+#include <cassert>
+
+namespace sql {
+
+group_commit::group_commit(connection& connection,
+                           const group_commit_options& options)
+    : connection_{connection}, options_{options} {
+  assert(options_.max_batch_size > 0);
+  thread_ = std::thread{[this] { Run(); }};
+}
+
+group_commit::~group_commit() {
+  queue_.push(operation{});
+  thread_.join();
+}
+
+std::future<void> group_commit::submit(write_callback write) {
+  assert(write);
+  operation operation{.write = std::move(write),
+                      .submit_time = std::chrono::steady_clock::now()};
+  auto future = operation.promise.get_future();
+  queue_.push(std::move(operation));
+  return future;
+}
+
+void group_commit::Run() {
+  std::vector<operation> batch;
+  batch.reserve(options_.max_batch_size);
+
+  while (!stopping_ || !queue_.empty()) {
+    CollectBatch(batch);
+    if (!batch.empty())
+      CommitBatch(batch);
+    batch.clear();
+  }
+}
+
+void group_commit::CollectBatch(std::vector<operation>& batch) {
+  auto push = [this, &batch](operation&& operation) {
+    if (operation.write)
+      batch.emplace_back(std::move(operation));
+    else
+      stopping_ = true;
+  };
+
+  auto drain = [this, &batch, &push] {
+    while (batch.size() < options_.max_batch_size) {
+      auto operation = queue_.try_pop();
+      if (!operation)
+        break;
+      push(std::move(*operation));
+    }
+  };
+
+  if (stopping_) {
+    drain();
+    return;
+  }
+
+  push(queue_.wait_pop());
+  drain();
+
+  // Waits for more writes until the batch is full. The delay counts from the
+  // submission of the first write, which happened before its pop.
+  auto deadline = batch.empty()
+                      ? std::chrono::steady_clock::now()
+                      : batch.front().submit_time + options_.max_delay;
+  while (!stopping_ && batch.size() < options_.max_batch_size) {
+    auto operation = queue_.wait_pop_until(deadline);
+    if (!operation)
+      break;
+    push(std::move(*operation));
+  }
+}
+
+void group_commit::CommitBatch(std::vector<operation>& batch) {
+  // Writes that are applied, but not yet committed.
+  std::vector<operation*> applied;
+  applied.reserve(batch.size());
+
+  size_t next = 0;
+
+  try {
+    transaction transaction{connection_, options_.transaction};
+
+    for (; next < batch.size(); ++next) {
+      auto& operation = batch[next];
+      try {
+        sql::transaction savepoint{transaction};
+        operation.write(connection_);
+        savepoint.commit();
+        applied.emplace_back(&operation);
+      } catch (...) {
+        operation.promise.set_exception(std::current_exception());
+      }
+    }
+
+    transaction.commit();
+
+  } catch (...) {
+    auto error = std::current_exception();
+    for (auto* operation : applied)
+      operation->promise.set_exception(error);
+    for (; next < batch.size(); ++next)
+      batch[next].promise.set_exception(error);
+    return;
+  }
+
+  for (auto* operation : applied)
+    operation->promise.set_value();
+}
+
+}  // namespace sql
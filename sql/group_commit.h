@@ -0,0 +1,67 @@
+#pragma once
+
+#include "sql/concurrent_queue.h"
+#include "sql/types.h"
+
+#include <chrono>
+#include <functional>
+#include <future>
+#include <thread>
+#include <vector>
+
+namespace sql {
+
+class connection;
+
+struct group_commit_options {
+  // A batch is committed once it holds this many writes...
+  size_t max_batch_size = 256;
+  // ...or once its first write has waited this long since its submission.
+  // With a zero delay, a batch holds whatever was submitted while the
+  // previous one committed.
+  std::chrono::microseconds max_delay{0};
+
+  transaction_options transaction{.mode = transaction_mode::IMMEDIATE};
+};
+
+// Coalesces small writes from many threads into shared transactions, so the
+// commit cost is paid once per batch instead of once per write. The
+// connection is used exclusively by the writer thread while the queue exists.
+class group_commit {
+ public:
+  using write_callback = std::function<void(connection& connection)>;
+
+  explicit group_commit(connection& connection,
+                        const group_commit_options& options = {});
+  // Commits the writes submitted before destruction.
+  ~group_commit();
+
+  group_commit(const group_commit&) = delete;
+  group_commit& operator=(const group_commit&) = delete;
+
+  // The future completes once the batch containing |write| commits. A write
+  // that throws is rolled back alone and its future receives the exception.
+  std::future<void> submit(write_callback write);
+
+ private:
+  struct operation {
+    // Empty for the stop request.
+    write_callback write;
+    std::chrono::steady_clock::time_point submit_time;
+    std::promise<void> promise;
+  };
+
+  void Run();
+  void CollectBatch(std::vector<operation>& batch);
+  void CommitBatch(std::vector<operation>& batch);
+
+  connection& connection_;
+  const group_commit_options options_;
+
+  concurrent_queue<operation> queue_;
+  bool stopping_ = false;
+
+  std::thread thread_;
+};
+
+}  // namespace sql
@@ -0,0 +1,98 @@
+#include "sql/group_commit.h"
+
+#include "sql/connection.h"
+#include "sql/statement.h"
+#include "sql/test/temp_dir.h"
+
+#include <gmock/gmock.h>
+
+using namespace testing;
+
+namespace sql {
+
+class GroupCommitTest : public Test {
+ public:
+  virtual void SetUp() override {
+    connection_.open({.path = temp_dir_.get() / "database.sqlite3"});
+    connection_.query("CREATE TABLE t(x INTEGER)");
+  }
+
+ protected:
+  int64_t CountRows() {
+    statement statement{connection_, "SELECT COUNT(*) FROM t"};
+    EXPECT_TRUE(statement.next());
+    return statement.at(0).as_int64();
+  }
+
+  static group_commit::write_callback Insert(int value) {
+    return [value](connection& connection) {
+      statement statement{connection, "INSERT INTO t VALUES(?)"};
+      statement.bind(0, value);
+      statement.query();
+    };
+  }
+
+  ScopedTempDir temp_dir_;
+  connection connection_;
+};
+
+TEST_F(GroupCommitTest, CommitsAllWrites) {
+  constexpr int kThreadCount = 4;
+  constexpr int kWriteCount = 50;
+
+  {
+    group_commit group_commit{
+        connection_,
+        {.max_batch_size = 16, .max_delay = std::chrono::milliseconds{1}}};
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kThreadCount; ++i) {
+      threads.emplace_back([&group_commit] {
+        std::vector<std::future<void>> futures;
+        for (int j = 0; j < kWriteCount; ++j)
+          futures.emplace_back(group_commit.submit(Insert(j)));
+        for (auto& future : futures)
+          EXPECT_NO_THROW(future.get());
+      });
+    }
+
+    for (auto& thread : threads)
+      thread.join();
+  }
+
+  EXPECT_EQ(kThreadCount * kWriteCount, CountRows());
+}
+
+TEST_F(GroupCommitTest, CommitsFullBatchBeforeDelay) {
+  group_commit group_commit{
+      connection_,
+      {.max_batch_size = 2, .max_delay = std::chrono::seconds{60}}};
+
+  auto first = group_commit.submit(Insert(1));
+  auto second = group_commit.submit(Insert(2));
+  EXPECT_EQ(std::future_status::ready,
+            second.wait_for(std::chrono::seconds{10}));
+  EXPECT_EQ(std::future_status::ready, first.wait_for(std::chrono::seconds{0}));
+}
+
+TEST_F(GroupCommitTest, FailedWriteIsRolledBackAlone) {
+  std::future<void> ok1, failed, ok2;
+
+  {
+    group_commit group_commit{connection_,
+                              {.max_delay = std::chrono::milliseconds{10}}};
+    ok1 = group_commit.submit(Insert(1));
+    failed = group_commit.submit([](connection& connection) {
+      Insert(2)(connection);
+      connection.query("INSERT INTO missing_table VALUES(1)");
+    });
+    ok2 = group_commit.submit(Insert(3));
+  }
+
+  EXPECT_NO_THROW(ok1.get());
+  EXPECT_THROW(failed.get(), std::exception);
+  EXPECT_NO_THROW(ok2.get());
+  EXPECT_EQ(2, CountRows());
+}
+
+}  // namespace sql
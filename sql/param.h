@@ -0,0 +1,164 @@
+#pragma once
+
+#include "sql/row.h"
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <ranges>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace sql {
+
+// A parameter value passed to `bind_params`. Strings are referenced, not
+// copied. Narrow strings are always `value_type::STRING_VIEW`.
+struct param_value {
+  value_type type = value_type::INT64;
+  bool is_null = true;
+  union {
+    bool bool_value;
+    int int_value;
+    int64_t int64_value = 0;
+    double double_value;
+    std::string_view string_value;
+    std::u16string_view string16_value;
+  };
+};
+
+namespace internal {
+
+inline param_value make_param(std::nullopt_t) {
+  return {};
+}
+
+inline param_value make_param(bool value) {
+  param_value param{};
+  param.type = value_type::BOOL;
+  param.is_null = false;
+  param.bool_value = value;
+  return param;
+}
+
+inline param_value make_param(int value) {
+  param_value param{};
+  param.type = value_type::INT;
+  param.is_null = false;
+  param.int_value = value;
+  return param;
+}
+
+inline param_value make_param(int64_t value) {
+  param_value param{};
+  param.type = value_type::INT64;
+  param.is_null = false;
+  param.int64_value = value;
+  return param;
+}
+
+inline param_value make_param(double value) {
+  param_value param{};
+  param.type = value_type::DOUBLE;
+  param.is_null = false;
+  param.double_value = value;
+  return param;
+}
+
+inline param_value make_param(std::string_view value) {
+  param_value param{};
+  param.type = value_type::STRING_VIEW;
+  param.is_null = false;
+  param.string_value = value;
+  return param;
+}
+
+// Avoids the implicit cast of c-strings to `bool`.
+inline param_value make_param(const char* value) {
+  return make_param(std::string_view{value});
+}
+
+inline param_value make_param(std::u16string_view value) {
+  param_value param{};
+  param.type = value_type::STRING16;
+  param.is_null = false;
+  param.string16_value = value;
+  return param;
+}
+
+inline param_value make_param(const char16_t* value) {
+  return make_param(std::u16string_view{value});
+}
+
+template <class T>
+param_value make_param(const std::optional<T>& value) {
+  return value ? make_param(*value) : param_value{};
+}
+
+// Packs |args| and binds them with a single `bind_params` call.
+template <class Statement, class... Args>
+void bind_all(Statement& statement, const Args&... args) {
+  if constexpr (sizeof...(Args) != 0) {
+    const std::array<param_value, sizeof...(Args)> params{make_param(args)...};
+    statement.bind_params(params);
+  }
+}
+
+// Binds |args|, runs |statement| and resets it, even on failure.
+template <class Statement, class... Args>
+void execute(Statement& statement, const Args&... args) {
+  bind_all(statement, args...);
+  try {
+    statement.query();
+  } catch (...) {
+    statement.reset();
+    throw;
+  }
+  statement.reset();
+}
+
+// The number of rows packed into a single `execute_batch` driver call.
+inline constexpr size_t kBatchRowCount = 1024;
+
+// Runs |statement| once per element of |rows|, a range of tuples or
+// aggregates, binding their members in order. The rows are passed to the
+// driver in batches of `kBatchRowCount`. Returns the affected row count of
+// each batch. String members are referenced until the driver call, so the rows
+// must not be temporaries produced by the range.
+template <class Statement, std::ranges::input_range Rows>
+std::vector<int64_t> execute_batch(Statement& statement, Rows&& rows) {
+  using Row = std::ranges::range_reference_t<Rows>;
+  static_assert(std::is_lvalue_reference_v<Row>,
+                "The rows must outlive the iteration, e.g. be stored in a "
+                "container, as their strings are bound by reference");
+  constexpr size_t param_count = std::tuple_size_v<
+      decltype(tie_members(std::declval<Row&>()))>;
+
+  std::vector<param_value> params;
+  params.reserve(kBatchRowCount * param_count);
+  size_t row_count = 0;
+  std::vector<int64_t> change_counts;
+
+  for (auto&& row : rows) {
+    std::apply(
+        [&params](const auto&... members) {
+          (params.push_back(make_param(members)), ...);
+        },
+        tie_members(row));
+    if (++row_count == kBatchRowCount) {
+      change_counts.push_back(statement.execute_batch(params, row_count));
+      params.clear();
+      row_count = 0;
+    }
+  }
+
+  if (row_count != 0)
+    change_counts.push_back(statement.execute_batch(params, row_count));
+  return change_counts;
+}
+
+}  // namespace internal
+
+}  // namespace sql
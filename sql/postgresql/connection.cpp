@@ -5,10 +5,14 @@
 #include "sql/postgresql/statement.h"
 
 #include <boost/algorithm/string.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
 #include <cassert>
 #include <format>
 #include <libpq-fe.h>
 #include <libpq/libpq-fs.h>
+#include <sstream>
+#include <utility>
 
 namespace sql::postgresql {
 
@@ -22,6 +26,65 @@ std::string ToLowerCase(std::string_view str) {
   return result;
 }
 
+std::string GetBeginTransactionSql(const transaction_options& options) {
+  std::string sql = "BEGIN TRANSACTION";
+
+  switch (options.isolation) {
+    case isolation_level::READ_COMMITTED:
+      sql += " ISOLATION LEVEL READ COMMITTED";
+      break;
+    case isolation_level::REPEATABLE_READ:
+      sql += " ISOLATION LEVEL REPEATABLE READ";
+      break;
+    case isolation_level::SERIALIZABLE:
+      sql += " ISOLATION LEVEL SERIALIZABLE";
+      break;
+    default:
+      break;
+  }
+
+  if (options.read_only)
+    sql += " READ ONLY";
+
+  // Has effect only for read-only serializable transactions.
+  if (options.deferrable)
+    sql += " DEFERRABLE";
+
+  return sql;
+}
+
+// `EXPLAIN` accepts only these statements.
+bool IsExplainable(std::string_view sql) {
+  constexpr std::string_view kKeywords[] = {"select", "insert", "update",
+                                            "delete", "with",   "values"};
+
+  auto begin = sql.find_first_not_of(" \t\r\n(");
+  if (begin == sql.npos)
+    return false;
+
+  auto keyword = ToLowerCase(sql.substr(begin, 6));
+  return std::ranges::any_of(kKeywords, [&keyword](std::string_view k) {
+    return keyword.starts_with(k);
+  });
+}
+
+query_plan_node ParsePlanNode(const boost::property_tree::ptree& tree) {
+  query_plan_node node{
+      .detail = tree.get<std::string>("Node Type", {}),
+      .table = tree.get<std::string>("Relation Name", {}),
+      .schema = tree.get<std::string>("Schema", {}),
+  };
+
+  node.full_scan = node.detail == "Seq Scan" && !node.table.empty();
+
+  if (auto plans = tree.get_child_optional("Plans")) {
+    for (const auto& [key, child] : *plans)
+      node.children.emplace_back(ParsePlanNode(child));
+  }
+
+  return node;
+}
+
 }  // namespace
 
 connection::connection(const open_params& params) {
@@ -43,6 +106,9 @@ void connection::open(const open_params& params) {
   }
 
   conn_ = conn;
+
+  full_scan_handler_ = params.full_scan_handler;
+  full_scan_row_threshold_ = params.full_scan_row_threshold;
 }
 
 void connection::close() {
@@ -54,6 +120,7 @@ void connection::close() {
   does_table_exist_statement_.reset();
   does_column_exist_statement_.reset();
   does_index_exist_statement_.reset();
+  table_row_count_statement_.reset();
 
   if (conn_) {
     PQfinish(conn_);
@@ -65,6 +132,16 @@ void connection::query(std::string_view sql) {
   CheckPostgresResult(PQexec(conn_, std::string{sql}.c_str()));
 }
 
+std::string connection::key_set_sql(std::string_view sql,
+                                    size_t /*key_count*/) const {
+  // The keys are bound as a single array, so |key_count| doesn't matter.
+  auto pos = sql::internal::FindKeySetPlaceholder(sql);
+  std::string result{sql.substr(0, pos)};
+  result += "= ANY(?)";
+  result += sql.substr(pos + sql::internal::kKeySetPlaceholder.size());
+  return result;
+}
+
 bool connection::table_exists(std::string_view table_name) const {
   if (!does_table_exist_statement_) {
     does_table_exist_statement_ =
@@ -132,6 +209,10 @@ void connection::start() {
   begin_transaction_statement_->reset();
 }
 
+void connection::start(const transaction_options& options) {
+  query(GetBeginTransactionSql(options));
+}
+
 void connection::commit() {
   if (!commit_transaction_statement_) {
     commit_transaction_statement_ =
@@ -152,6 +233,18 @@ void connection::rollback() {
   rollback_transaction_statement_->reset();
 }
 
+void connection::savepoint(std::string_view name) {
+  query(std::format("SAVEPOINT {}", name));
+}
+
+void connection::release_savepoint(std::string_view name) {
+  query(std::format("RELEASE SAVEPOINT {}", name));
+}
+
+void connection::rollback_to_savepoint(std::string_view name) {
+  query(std::format("ROLLBACK TO SAVEPOINT {}", name));
+}
+
 int connection::last_change_count() const {
   return last_change_count_;
 }
@@ -187,4 +280,133 @@ std::vector<field_info> connection::table_fields(
   return fields;
 }
 
+query_plan connection::Explain(std::string_view sql,
+                               std::span<const Oid> param_types,
+                               const char* const* param_values,
+                               const int* param_lengths) const {
+  bool explaining = std::exchange(explaining_, true);
+
+  try {
+    std::vector<int> param_formats(param_types.size(), 1);
+
+    result res{PQexecParams(
+        conn_, std::format("EXPLAIN (FORMAT JSON, VERBOSE) {}", sql).c_str(),
+        static_cast<int>(param_types.size()), param_types.data(), param_values,
+        param_lengths, param_formats.data(), 0)};
+    CheckPostgresResult(res.get());
+
+    auto json = res.value(0);
+    std::istringstream stream{std::string{json.begin(), json.end()}};
+    boost::property_tree::ptree tree;
+    boost::property_tree::read_json(stream, tree);
+
+    query_plan plan;
+    for (const auto& [key, child] : tree) {
+      if (auto root = child.get_child_optional("Plan"))
+        plan.nodes.emplace_back(ParsePlanNode(*root));
+    }
+
+    auto set_table_rows = [this](auto& self,
+                                 std::vector<query_plan_node>& nodes) -> void {
+      for (auto& node : nodes) {
+        if (node.full_scan)
+          node.table_rows = GetTableRowCount(node.schema, node.table);
+        self(self, node.children);
+      }
+    };
+    set_table_rows(set_table_rows, plan.nodes);
+
+    explaining_ = explaining;
+    return plan;
+
+  } catch (const boost::property_tree::json_parser_error& e) {
+    explaining_ = explaining;
+    throw Exception{e.what()};
+  } catch (...) {
+    explaining_ = explaining;
+    throw;
+  }
+}
+
+void connection::CheckFullScans(std::string_view sql,
+                                std::span<const Oid> param_types) const {
+  assert(full_scan_handler_);
+
+  if (explaining_ || !IsExplainable(sql))
+    return;
+
+  // A custom plan for null parameters folds the conditions on them, e.g.
+  // `col=$1` becomes a false one-time filter, so the generic plan is explained.
+  constexpr char kStatementName[] = "sql_full_scan_check";
+  result prepared{PQprepare(conn_, kStatementName, std::string{sql}.c_str(),
+                            static_cast<int>(param_types.size()),
+                            param_types.data())};
+  CheckPostgresResult(prepared.get());
+
+  std::string execute_sql = std::format("EXECUTE {}", kStatementName);
+  for (size_t i = 0; i < param_types.size(); ++i)
+    execute_sql += i == 0 ? "(NULL" : ", NULL";
+  if (!param_types.empty())
+    execute_sql += ")";
+
+  std::string plan_cache_mode;
+  auto restore = [&] {
+    if (!plan_cache_mode.empty()) {
+      const char* values[] = {plan_cache_mode.c_str()};
+      result{PQexecParams(conn_,
+                          "SELECT set_config('plan_cache_mode', $1, false)", 1,
+                          nullptr, values, nullptr, nullptr, 0)};
+    }
+    result{PQexec(conn_, std::format("DEALLOCATE {}", kStatementName).c_str())};
+  };
+
+  query_plan plan;
+  try {
+    result mode{PQexec(conn_,
+                       "SELECT current_setting('plan_cache_mode'), "
+                       "set_config('plan_cache_mode', 'force_generic_plan', "
+                       "false)")};
+    CheckPostgresResult(mode.get());
+    auto value = mode.value(0);
+    plan_cache_mode.assign(value.begin(), value.end());
+
+    plan = Explain(execute_sql, {}, nullptr, nullptr);
+  } catch (...) {
+    restore();
+    throw;
+  }
+  restore();
+
+  for (auto* scan : plan.full_scans(full_scan_row_threshold_))
+    full_scan_handler_(sql, *scan);
+}
+
+double connection::GetTableRowCount(std::string_view schema_name,
+                                    std::string_view table_name) const {
+  if (schema_name.empty())
+    return -1;
+
+  // Resolves the qualified name, as equally named tables may exist in other
+  // schemas.
+  if (!table_row_count_statement_) {
+    table_row_count_statement_ = std::make_unique<statement>(
+        *const_cast<connection*>(this),
+        "SELECT c.reltuples::bigint FROM pg_class c "
+        "JOIN pg_namespace n ON n.oid=c.relnamespace "
+        "WHERE c.oid=to_regclass(format('%I.%I', ?::text, ?::text))");
+  }
+
+  table_row_count_statement_->bind(0, schema_name);
+  table_row_count_statement_->bind(1, table_name);
+
+  // `reltuples` is negative until the table is vacuumed or analyzed.
+  double count = table_row_count_statement_->next()
+                     ? table_row_count_statement_->at(0).as_int64()
+                     : -1;
+
+  table_row_count_statement_->reset();
+
+  return count;
+}
+
 }  // namespace sql::postgresql
@@ -1,9 +1,14 @@
 #pragma once
 
+#include "sql/fetch_many.h"
+#include "sql/query_range.h"
 #include "sql/types.h"
 
 #include <atomic>
+#include <functional>
 #include <memory>
+#include <postgres_ext.h>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -33,10 +38,35 @@ class connection {
 
   void query(std::string_view sql);
 
+  // Runs |sql| with |args| bound to its parameters and returns an input range
+  // of |Row|s. See `query_range`.
+  template <class Row, class... Args>
+  query_range<Row, statement> query(std::string_view sql,
+                                    const Args&... args) {
+    return {*this, sql, args...};
+  }
+
+  // Looks up the rows of |keys| with one set-based query per chunk of keys and
+  // returns them by key. |sql| selects the key as the first member of |Row|
+  // and filters it with `IN (?)`, its only parameter. See `fetch_many`.
+  template <class Row, std::ranges::input_range Keys>
+  auto fetch_many(std::string_view sql, Keys&& keys) {
+    return sql::internal::fetch_many<Row>(*this, sql, keys);
+  }
+
+  // Rewrites the `IN (?)` key set placeholder of |sql| for |key_count| keys
+  // bound with `statement::bind_key_set`.
+  std::string key_set_sql(std::string_view sql, size_t key_count) const;
+
   void start();
+  void start(const transaction_options& options);
   void commit();
   void rollback();
 
+  void savepoint(std::string_view name);
+  void release_savepoint(std::string_view name);
+  void rollback_to_savepoint(std::string_view name);
+
   int last_change_count() const;
 
   bool table_exists(std::string_view table_name) const;
@@ -50,6 +80,17 @@ class connection {
  private:
   std::string GenerateStatementName();
 
+  // Runs `EXPLAIN (FORMAT JSON)` for |sql| with binary parameters.
+  query_plan Explain(std::string_view sql,
+                     std::span<const Oid> param_types,
+                     const char* const* param_values,
+                     const int* param_lengths) const;
+  // Explains the generic plan of |sql|.
+  void CheckFullScans(std::string_view sql,
+                      std::span<const Oid> param_types) const;
+  double GetTableRowCount(std::string_view schema_name,
+                          std::string_view table_name) const;
+
   ::PGconn* conn_ = nullptr;
 
   mutable std::unique_ptr<statement> begin_transaction_statement_;
@@ -60,6 +101,13 @@ class connection {
   mutable std::unique_ptr<statement> does_table_exist_statement_;
   mutable std::unique_ptr<statement> does_column_exist_statement_;
   mutable std::unique_ptr<statement> does_index_exist_statement_;
+  mutable std::unique_ptr<statement> table_row_count_statement_;
+
+  std::function<void(std::string_view sql, const query_plan_node& scan)>
+      full_scan_handler_;
+  double full_scan_row_threshold_ = 0;
+  // Prevents checking the statements prepared by `Explain` itself.
+  mutable bool explaining_ = false;
 
   std::atomic<int> next_statement_id_ = 0;
 
@@ -47,16 +47,24 @@ class result {
     return PQresultErrorMessage(result_);
   }
 
-  bool is_null(int field_index) const {
-    return PQgetisnull(result_, 0, field_index);
+  bool is_null(int field_index) const { return is_null(0, field_index); }
+
+  bool is_null(int row, int field_index) const {
+    return PQgetisnull(result_, row, field_index);
   }
 
   std::span<const char> value(int field_index) const {
-    int size = PQgetlength(result_, 0, field_index);
-    const char* data = PQgetvalue(result_, 0, field_index);
+    return value(0, field_index);
+  }
+
+  std::span<const char> value(int row, int field_index) const {
+    int size = PQgetlength(result_, row, field_index);
+    const char* data = PQgetvalue(result_, row, field_index);
     return std::span<const char>{data, data + size};
   }
 
+  int row_count() const { return PQntuples(result_); }
+
   int field_count() const { return PQnfields(result_); }
   std::string_view field_name(int index) const {
     return PQfname(result_, index);
@@ -9,6 +9,7 @@
 
 #include <boost/algorithm/string/replace.hpp>
 #include <boost/locale/encoding_utf.hpp>
+#include <algorithm>
 #include <cassert>
 #include <format>
 #include <ranges>
@@ -19,6 +20,31 @@ namespace {
 
 const size_t AVG_PARAM_COUNT = 16;
 
+// The number of pipelined executions between syncs in `execute_batch`.
+const size_t PIPELINE_ROW_COUNT = 256;
+
+// The parameter arrays of `PQexecPrepared` and `PQsendQueryPrepared`, all in
+// the binary format.
+struct ParamArrays {
+  template <class Params>
+  explicit ParamArrays(const Params& params)
+      : values(params.size()),
+        lengths(params.size()),
+        formats(params.size(), 1) {
+    for (size_t i = 0; i < params.size(); ++i) {
+      const auto& buffer = params[i].buffer;
+      // |small_vector| returns non-null data even when is empty, so empty
+      // strings are not sent as NULL.
+      values[i] = params[i].is_null ? nullptr : buffer.data();
+      lengths[i] = static_cast<int>(buffer.size());
+    }
+  }
+
+  boost::container::small_vector<const char*, AVG_PARAM_COUNT> values;
+  boost::container::small_vector<int, AVG_PARAM_COUNT> lengths;
+  boost::container::small_vector<int, AVG_PARAM_COUNT> formats;
+};
+
 // Returns parameter count.
 // TODO: Optimize.
 size_t ReplacePostgresParameters(std::string& sql) {
@@ -35,6 +61,179 @@ size_t ReplacePostgresParameters(std::string& sql) {
   return 0;
 }
 
+// Throws for the types whose binary format is not read by the driver.
+field_type GetFieldType(Oid type) {
+  switch (type) {
+    case BOOLOID:
+    case INT2OID:
+    case INT4OID:
+    case INT8OID:
+      return field_type::INTEGER;
+    case FLOAT4OID:
+    case FLOAT8OID:
+      return field_type::FLOAT;
+    case BYTEAOID:
+      return field_type::BLOB;
+    case TEXTOID:
+    case VARCHAROID:
+    case NAMEOID:
+    case BPCHAROID:
+      return field_type::TEXT;
+    default:
+      throw Exception{std::format("Unsupported column type {}", type)};
+  }
+}
+
+// Names of the types known to the driver.
+const char* GetTypeName(Oid type) {
+  switch (type) {
+    case BOOLOID:
+      return "bool";
+    case BYTEAOID:
+      return "bytea";
+    case NAMEOID:
+      return "name";
+    case INT2OID:
+      return "int2";
+    case INT4OID:
+      return "int4";
+    case INT8OID:
+      return "int8";
+    case FLOAT4OID:
+      return "float4";
+    case FLOAT8OID:
+      return "float8";
+    case TEXTOID:
+      return "text";
+    case VARCHAROID:
+      return "varchar";
+    default:
+      return "";
+  }
+}
+
+// Reads the results of a pipeline up to its sync point. Returns the affected
+// row count and keeps the first error in |error|.
+int64_t ReceivePipelineResults(::PGconn* conn, std::string& error) {
+  int64_t change_count = 0;
+  bool query_done = false;
+  for (;;) {
+    result res{PQgetResult(conn)};
+    if (!res) {
+      // Two ends in a row mean the connection gave up before the sync point.
+      if (query_done) {
+        if (error.empty())
+          error = PQerrorMessage(conn);
+        return change_count;
+      }
+      query_done = true;
+      continue;
+    }
+    query_done = false;
+    switch (res.status()) {
+      case PGRES_PIPELINE_SYNC:
+        return change_count;
+      case PGRES_COMMAND_OK:
+      case PGRES_TUPLES_OK:
+        change_count += res.affected_row_count();
+        break;
+      case PGRES_PIPELINE_ABORTED:
+        break;
+      default:
+        if (error.empty())
+          error = PQresultErrorMessage(res.get());
+        break;
+    }
+  }
+}
+
+// Returns the element type of the array |type| known to the driver, or
+// `InvalidOid`.
+Oid GetArrayElementType(Oid type) {
+  switch (type) {
+    case INT4ARRAYOID:
+      return INT4OID;
+    case INT8ARRAYOID:
+      return INT8OID;
+    case TEXTARRAYOID:
+      return TEXTOID;
+    case VARCHARARRAYOID:
+      return VARCHAROID;
+    default:
+      return InvalidOid;
+  }
+}
+
+template <class T>
+void AppendBigEndian(boost::container::small_vector<char, 8>& buffer,
+                     T value) {
+  value = boost::endian::native_to_big(value);
+  const char* bytes = reinterpret_cast<const char*>(&value);
+  buffer.insert(buffer.end(), bytes, bytes + sizeof(value));
+}
+
+// Encodes |values| as a one-dimensional array of |type| in the binary format.
+void SetBufferArray(std::span<const param_value> values,
+                    Oid type,
+                    boost::container::small_vector<char, 8>& buffer) {
+  Oid element_type = GetArrayElementType(type);
+  if (element_type == InvalidOid)
+    throw Exception{"Unsupported array parameter type"};
+
+  bool has_nulls = std::ranges::any_of(
+      values, [](const param_value& value) { return value.is_null; });
+
+  buffer.clear();
+  AppendBigEndian(buffer, int32_t{1});
+  AppendBigEndian(buffer, int32_t{has_nulls ? 1 : 0});
+  AppendBigEndian(buffer, static_cast<uint32_t>(element_type));
+  AppendBigEndian(buffer, static_cast<int32_t>(values.size()));
+  // The lower bound.
+  AppendBigEndian(buffer, int32_t{1});
+
+  boost::container::small_vector<char, 8> element;
+  for (const auto& value : values) {
+    if (value.is_null) {
+      AppendBigEndian(buffer, int32_t{-1});
+      continue;
+    }
+    switch (value.type) {
+      case value_type::BOOL:
+        SetBufferValue(static_cast<int64_t>(value.bool_value ? 1 : 0),
+                       element_type, element);
+        break;
+      case value_type::INT:
+        SetBufferValue(static_cast<int64_t>(value.int_value), element_type,
+                       element);
+        break;
+      case value_type::INT64:
+        SetBufferValue(value.int64_value, element_type, element);
+        break;
+      case value_type::DOUBLE:
+        SetBufferValue(value.double_value, element_type, element);
+        break;
+      case value_type::STRING_VIEW:
+      case value_type::STRING:
+        SetBufferValue(value.string_value, element_type, element);
+        break;
+      case value_type::STRING16:
+        SetBufferValue(boost::locale::conv::utf_to_utf<char>(
+                           value.string16_value.data(),
+                           value.string16_value.data() +
+                               value.string16_value.size()),
+                       element_type, element);
+        break;
+    }
+    AppendBigEndian(buffer, static_cast<int32_t>(element.size()));
+    buffer.insert(buffer.end(), element.begin(), element.end());
+  }
+}
+
+int64_t GetBufferInteger(Oid type, std::span<const char> buffer) {
+  return type == BOOLOID ? (buffer[0] != 0 ? 1 : 0)
+                         : GetBufferInt64(type, buffer);
+}
+
 }  // namespace
 
 statement::statement(connection& connection, std::string_view sql) {
@@ -67,36 +266,50 @@ void statement::prepare(connection& connection, std::string_view sql) {
     for (int i = 0; i < res.param_count(); ++i) {
       params_[i].type = res.param_type(i);
     }
+
+    std::vector<column_info> columns(res.field_count());
+    for (int i = 0; i < res.field_count(); ++i) {
+      Oid type = res.field_type(i);
+      columns[i] = {.name = std::string{res.field_name(i)},
+                    .declared_type = GetTypeName(type),
+                    .type_oid = type};
+    }
+    columns_ = column_set{std::move(columns)};
   }
 
   connection_ = &connection;
   conn_ = connection.conn_;
   name_ = std::move(name);
-
-#ifndef NDEBUG
   sql_ = std::move(sanitized_sql);
-#endif
+
+  if (connection.full_scan_handler_)
+    connection.CheckFullScans(sql_, param_types());
 }
 
 void statement::bind_null(unsigned column) {
+  params_[column].is_null = true;
   params_[column].buffer.clear();
 }
 
 void statement::bind(unsigned column, bool value) {
+  params_[column].is_null = false;
   SetBufferValue(static_cast<int64_t>(value ? 1 : 0), params_[column].type,
                  params_[column].buffer);
 }
 
 void statement::bind(unsigned column, int value) {
+  params_[column].is_null = false;
   SetBufferValue(static_cast<int64_t>(value), params_[column].type,
                  params_[column].buffer);
 }
 
 void statement::bind(unsigned column, int64_t value) {
+  params_[column].is_null = false;
   SetBufferValue(value, params_[column].type, params_[column].buffer);
 }
 
 void statement::bind(unsigned column, double value) {
+  params_[column].is_null = false;
   SetBufferValue(value, params_[column].type, params_[column].buffer);
 }
 
@@ -109,19 +322,125 @@ void statement::bind(unsigned column, const char16_t* value) {
 }
 
 void statement::bind(unsigned column, std::string_view value) {
+  params_[column].is_null = false;
   SetBufferValue(value, params_[column].type, params_[column].buffer);
 }
 
 void statement::bind(unsigned column, std::u16string_view value) {
+  params_[column].is_null = false;
   SetBufferValue(boost::locale::conv::utf_to_utf<char>(
                      value.data(), value.data() + value.size()),
                  params_[column].type, params_[column].buffer);
 }
 
+void statement::bind_params(std::span<const param_value> params) {
+  assert(params.size() <= params_.size());
+  for (size_t i = 0; i < params.size(); ++i) {
+    const auto& param = params[i];
+    auto& [type, is_null, buffer] = params_[i];
+    is_null = param.is_null;
+    if (param.is_null) {
+      buffer.clear();
+      continue;
+    }
+    switch (param.type) {
+      case value_type::BOOL:
+        SetBufferValue(static_cast<int64_t>(param.bool_value ? 1 : 0), type,
+                       buffer);
+        break;
+      case value_type::INT:
+        SetBufferValue(static_cast<int64_t>(param.int_value), type, buffer);
+        break;
+      case value_type::INT64:
+        SetBufferValue(param.int64_value, type, buffer);
+        break;
+      case value_type::DOUBLE:
+        SetBufferValue(param.double_value, type, buffer);
+        break;
+      case value_type::STRING_VIEW:
+      case value_type::STRING:
+        SetBufferValue(param.string_value, type, buffer);
+        break;
+      case value_type::STRING16:
+        bind(static_cast<unsigned>(i), param.string16_value);
+        break;
+    }
+  }
+}
+
+void statement::bind_key_set(std::span<const param_value> keys) {
+  assert(params_.size() == 1);
+  params_[0].is_null = false;
+  SetBufferArray(keys, params_[0].type, params_[0].buffer);
+}
+
+int64_t statement::execute_batch(std::span<const param_value> params,
+                                 size_t row_count) {
+  assert(conn_);
+  assert(row_count == 0 || params.size() % row_count == 0);
+
+  if (row_count == 0)
+    return 0;
+
+  reset();
+
+  if (PQenterPipelineMode(conn_) != 1)
+    throw Exception{PQerrorMessage(conn_)};
+
+  size_t param_count = params.size() / row_count;
+  int64_t change_count = 0;
+  std::string error;
+
+  // Syncs periodically, so that the unread results never fill up the socket
+  // buffers and block the sending.
+  for (size_t row = 0; row < row_count && error.empty();) {
+    size_t end_row = std::min(row + PIPELINE_ROW_COUNT, row_count);
+    for (; row < end_row; ++row) {
+      bind_params(params.subspan(row * param_count, param_count));
+      if (!SendQueryPrepared()) {
+        error = PQerrorMessage(conn_);
+        break;
+      }
+    }
+    if (PQpipelineSync(conn_) != 1) {
+      if (error.empty())
+        error = PQerrorMessage(conn_);
+      break;
+    }
+    change_count += ReceivePipelineResults(conn_, error);
+  }
+
+  // Fails while results are pending, e.g. after a failed sync. Drains them
+  // through another sync, if the connection still takes one.
+  if (PQexitPipelineMode(conn_) != 1) {
+    if (PQpipelineSync(conn_) == 1)
+      ReceivePipelineResults(conn_, error);
+    if (PQexitPipelineMode(conn_) != 1 && error.empty())
+      error = PQerrorMessage(conn_);
+  }
+
+  std::ranges::for_each(params_, [](auto& param) {
+    param.is_null = true;
+    param.buffer.clear();
+  });
+
+  if (!error.empty())
+    throw Exception{error};
+
+  return change_count;
+}
+
 size_t statement::field_count() const {
   assert(conn_);
-  assert(false);
-  return 0;
+  return columns_.size();
+}
+
+std::span<const column_info> statement::columns() const {
+  return columns_.get();
+}
+
+std::optional<unsigned> statement::find_column(std::string_view name) const {
+  return columns_.find(name);
 }
 
 field_type statement::type(unsigned column) const {
@@ -132,6 +451,10 @@ field_view statement::at(unsigned column) const {
   return field_view{result_, static_cast<int>(column)};
 }
 
+void statement::read_fields(std::span<const column_target> targets) const {
+  sql::internal::read_fields(*this, targets);
+}
+
 void statement::query() {
   assert(conn_);
 
@@ -159,7 +482,10 @@ void statement::reset() {
   assert(conn_);
 
   result_.reset();
-  std::ranges::for_each(params_, [](auto& param) { param.buffer.clear(); });
+  std::ranges::for_each(params_, [](auto& param) {
+    param.is_null = true;
+    param.buffer.clear();
+  });
 
   for (;;) {
     result result{PQgetResult(conn_)};
@@ -171,6 +497,56 @@ void statement::reset() {
   executed_ = false;
 }
 
+size_t statement::fetch_batch(column_batch& batch, size_t max_rows) {
+  assert(conn_);
+
+  // The whole result is received at once, and the batches are sliced from it.
+  if (!executed_) {
+    query(false);
+    batch_row_ = 0;
+  }
+
+  int column_count = result_.field_count();
+  batch.clear(column_count);
+
+  for (int i = 0; i < column_count; ++i) {
+    auto& column = batch.column(i);
+    if (column.type() == field_type::EMPTY)
+      column.set_type(GetFieldType(result_.field_type(i)));
+  }
+
+  for (int row_count = result_.row_count();
+       batch_row_ < row_count && batch.row_count() < max_rows; ++batch_row_) {
+    for (int i = 0; i < column_count; ++i) {
+      auto& column = batch.column(i);
+      if (result_.is_null(batch_row_, i)) {
+        column.append_null();
+        continue;
+      }
+
+      Oid type = result_.field_type(i);
+      auto value = result_.value(batch_row_, i);
+      switch (column.type()) {
+        case field_type::INTEGER:
+          column.append_integer(GetBufferInteger(type, value));
+          break;
+        case field_type::FLOAT:
+          column.append_float(GetBufferDouble(type, value));
+          break;
+        case field_type::TEXT:
+        case field_type::BLOB:
+          column.append_string(std::string_view{value.data(), value.size()});
+          break;
+        case field_type::EMPTY:
+          break;
+      }
+    }
+    batch.end_row();
+  }
+
+  return batch.row_count();
+}
+
 void statement::close() {
   result_.reset();
 
@@ -180,16 +556,13 @@ void statement::close() {
   }
 }
 
-void statement::query(bool single_row) {
-  if (executed_) {
-    return;
-  }
+query_plan statement::explain() const {
+  assert(conn_);
 
   boost::container::small_vector<const char*, AVG_PARAM_COUNT> param_values(
       params_.size());
   std::ranges::transform(params_, param_values.begin(), [](auto&& p) {
-    // |small_vector| returns non-null data even when is empty.
-    return p.buffer.empty() ? nullptr : p.buffer.data();
+    return p.is_null ? nullptr : p.buffer.data();
   });
 
   boost::container::small_vector<int, AVG_PARAM_COUNT> param_lengths(
@@ -198,28 +571,38 @@ void statement::query(bool single_row) {
     return static_cast<int>(p.buffer.size());
   });
 
-  boost::container::small_vector<int, AVG_PARAM_COUNT> param_formats(
-      params_.size(), 1);
+  return connection_->Explain(sql_, param_types(), param_values.data(),
+                              param_lengths.data());
+}
 
-  if (single_row) {
-    int result = PQsendQueryPrepared(
-        conn_, name_.c_str(), static_cast<int>(param_values.size()),
-        param_values.data(), param_lengths.data(), param_formats.data(), 1);
+std::vector<Oid> statement::param_types() const {
+  std::vector<Oid> types(params_.size());
+  std::ranges::transform(params_, types.begin(),
+                         [](auto&& p) { return p.type; });
+  return types;
+}
 
-    if (result != PGRES_COMMAND_OK) {
+void statement::query(bool single_row) {
+  if (executed_) {
+    return;
+  }
+
+  if (single_row) {
+    if (!SendQueryPrepared()) {
       const char* error_message = PQerrorMessage(conn_);
       throw Exception{error_message};
     }
 
-    if (PQsetSingleRowMode(conn_) != PGRES_COMMAND_OK) {
+    if (PQsetSingleRowMode(conn_) != 1) {
       const char* error_message = PQerrorMessage(conn_);
       throw Exception{error_message};
     }
 
   } else {
+    ParamArrays arrays{params_};
     result_.reset(PQexecPrepared(
-        conn_, name_.c_str(), static_cast<int>(param_values.size()),
-        param_values.data(), param_lengths.data(), param_formats.data(), 1));
+        conn_, name_.c_str(), static_cast<int>(params_.size()),
+        arrays.values.data(), arrays.lengths.data(), arrays.formats.data(), 1));
 
     CheckPostgresResult(result_.get());
 
@@ -230,4 +613,12 @@ void statement::query(bool single_row) {
   executed_ = true;
 }
 
+bool statement::SendQueryPrepared() {
+  ParamArrays arrays{params_};
+  return PQsendQueryPrepared(conn_, name_.c_str(),
+                             static_cast<int>(params_.size()),
+                             arrays.values.data(), arrays.lengths.data(),
+                             arrays.formats.data(), 1) == 1;
+}
+
 }  // namespace sql::postgresql
@@ -1,11 +1,18 @@
 #pragma once
 
 #include "sql/postgresql/field_view.h"
+#include "sql/column_batch.h"
+#include "sql/column_set.h"
+#include "sql/param.h"
 #include "sql/postgresql/result.h"
+#include "sql/row.h"
 #include "sql/types.h"
 
 #include <boost/container/small_vector.hpp>
+#include <optional>
+#include <span>
 #include <string>
+#include <tuple>
 #include <vector>
 
 namespace sql::postgresql {
@@ -36,27 +43,95 @@ class statement {
   void bind(unsigned column, std::string_view value);
   void bind(unsigned column, std::u16string_view value);
 
+  // Binds |params| to the parameters from the first one with a single driver
+  // call.
+  void bind_params(std::span<const param_value> params);
+
+  // Binds |keys| to a statement prepared from `connection::key_set_sql`.
+  void bind_key_set(std::span<const param_value> keys);
+
+  // Binds |args| to the parameters in order. An empty `std::optional` binds
+  // NULL.
+  template <class... Args>
+  void bind_all(const Args&... args) {
+    sql::internal::bind_all(*this, args...);
+  }
+
+  // Binds |args|, runs the statement and resets it.
+  template <class... Args>
+  void execute(const Args&... args) {
+    sql::internal::execute(*this, args...);
+  }
+
+  // Runs the statement once per element of |rows|, a range of tuples or
+  // aggregates, and returns the affected row count of each driver call.
+  template <std::ranges::input_range Rows>
+  std::vector<int64_t> execute_batch(Rows&& rows) {
+    return sql::internal::execute_batch(*this, std::forward<Rows>(rows));
+  }
+
+  // Runs the statement |row_count| times, binding consecutive equal slices of
+  // |params|, with a single driver call. Returns the total affected row count.
+  int64_t execute_batch(std::span<const param_value> params, size_t row_count);
+
   size_t field_count() const;
+
+  // Describes the result columns. Computed once per prepared statement.
+  std::span<const column_info> columns() const;
+  // Returns the index of the result column named |name|.
+  std::optional<unsigned> find_column(std::string_view name) const;
   field_type type(unsigned column) const;
   field_view at(unsigned column) const;
 
+  // Decodes the current row into |targets| with a single driver call.
+  void read_fields(std::span<const column_target> targets) const;
+
+  // Reads the current row as a tuple. NULL values map to empty
+  // `std::optional`s and to default values of other types.
+  template <class... Ts>
+  std::tuple<Ts...> read_row() const {
+    std::tuple<Ts...> row;
+    sql::internal::read_row(*this, row);
+    return row;
+  }
+
+  // Fills the members of the aggregate |row| in declaration order.
+  template <class Row>
+  void read_row(Row& row) const {
+    sql::internal::read_row(*this, row);
+  }
+
   void query();
   bool next();
   void reset();
 
+  // Reads up to |max_rows| rows into |batch| and returns their count, which is
+  // 0 once the rows are exhausted. See `column_batch`. Throws for columns of
+  // other than integer, floating-point, text and bytea types.
+  size_t fetch_batch(column_batch& batch, size_t max_rows);
+
   void close();
 
+  // Runs `EXPLAIN (FORMAT JSON)` with the currently bound parameters.
+  query_plan explain() const;
+
  private:
   using ParamBuffer = boost::container::small_vector<char, 8>;
 
   struct Param {
     // The parameter type in assigned on `create`.
     Oid type = InvalidOid;
-    // Empty buffer is used for null values.
+    bool is_null = true;
+    // Empty for null values.
     ParamBuffer buffer;
   };
 
   void query(bool single_row);
+  // Sends the execution with the bound parameters without waiting for the
+  // result. Returns false on failure.
+  bool SendQueryPrepared();
+
+  std::vector<Oid> param_types() const;
 
   connection* connection_ = nullptr;
   ::PGconn* conn_ = nullptr;
@@ -64,14 +139,18 @@ class statement {
 
   std::string name_;
 
-  // For debugging purposes only.
-#ifndef NDEBUG
+  // With parameters replaced by `$n`.
   std::string sql_;
-#endif
 
   std::vector<Param> params_;
 
+  // Described on `prepare`.
+  column_set columns_;
+
   bool executed_ = false;
+
+  // The next row of |result_| to return from `fetch_batch`.
+  int batch_row_ = 0;
 };
 
 }  // namespace sql::postgresql
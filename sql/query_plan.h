@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace sql {
+
+struct query_plan_node {
+  // SQLite: the plan line, e.g. "SCAN t". PostgreSQL: the node type, e.g.
+  // "Seq Scan".
+  std::string detail;
+  // The table the node reads, if any. SQLite reports the alias when the
+  // table is aliased in the query.
+  std::string table;
+  // PostgreSQL only. The schema of |table|.
+  std::string schema;
+  // The node reads every row of |table|.
+  bool full_scan = false;
+  // Number of rows in |table| for full scans. Negative if unknown.
+  double table_rows = -1;
+
+  std::vector<query_plan_node> children;
+};
+
+struct query_plan {
+  std::vector<query_plan_node> nodes;
+
+  // Returns the full scans of tables holding at least |row_threshold| rows,
+  // including scans of tables of unknown size.
+  std::vector<const query_plan_node*> full_scans(
+      double row_threshold = 0) const {
+    std::vector<const query_plan_node*> result;
+    CollectFullScans(nodes, row_threshold, result);
+    return result;
+  }
+
+ private:
+  static void CollectFullScans(const std::vector<query_plan_node>& nodes,
+                               double row_threshold,
+                               std::vector<const query_plan_node*>& result) {
+    for (const auto& node : nodes) {
+      if (node.full_scan &&
+          (node.table_rows < 0 || node.table_rows >= row_threshold)) {
+        result.emplace_back(&node);
+      }
+      CollectFullScans(node.children, row_threshold, result);
+    }
+  }
+};
+
+}  // namespace sql
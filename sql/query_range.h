@@ -0,0 +1,86 @@
+#pragma once
+
+#include "sql/row.h"
+
+#include <cstddef>
+#include <iterator>
+#include <string_view>
+
+namespace sql {
+
+// An input range over the rows of a query, returned by `connection::query`.
+// Each row is decoded into the same |Row| buffer with one `read_fields` call,
+// and the column targets are resolved once, so iteration doesn't allocate
+// apart from string members. A row is valid until the iterator advances.
+//
+// Neither copyable nor movable, as it owns the statement. Iterate it in
+// place, e.g. `for (auto& row : connection.query<Row>(sql, args...))`.
+template <class Row, class Statement>
+class query_range {
+ public:
+  class iterator {
+   public:
+    using value_type = Row;
+    using difference_type = std::ptrdiff_t;
+
+    iterator() = default;
+
+    Row& operator*() const { return range_->row_; }
+    Row* operator->() const { return &range_->row_; }
+
+    iterator& operator++() {
+      range_->Next();
+      return *this;
+    }
+    void operator++(int) { ++*this; }
+
+    bool operator==(std::default_sentinel_t) const {
+      return !range_ || range_->done_;
+    }
+
+   private:
+    explicit iterator(query_range& range) : range_{&range} {}
+
+    query_range* range_ = nullptr;
+
+    friend class query_range;
+  };
+
+  template <class Connection, class... Args>
+  query_range(Connection& connection,
+              std::string_view sql,
+              const Args&... args)
+      : statement_{connection, sql},
+        targets_{internal::make_column_targets(row_)} {
+    statement_.bind_all(args...);
+  }
+
+  query_range(const query_range&) = delete;
+  query_range& operator=(const query_range&) = delete;
+
+  // Can be called once, as the rows are read only once.
+  iterator begin() {
+    if (!started_) {
+      started_ = true;
+      Next();
+    }
+    return iterator{*this};
+  }
+
+  std::default_sentinel_t end() const { return {}; }
+
+ private:
+  void Next() {
+    done_ = !statement_.next();
+    if (!done_)
+      statement_.read_fields(targets_);
+  }
+
+  Statement statement_;
+  Row row_{};
+  const decltype(internal::make_column_targets(std::declval<Row&>())) targets_;
+  bool started_ = false;
+  bool done_ = false;
+};
+
+}  // namespace sql
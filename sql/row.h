@@ -0,0 +1,300 @@
+#pragma once
+
+#include "sql/types.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace sql {
+
+// Type of a value decoded by `read_fields`.
+enum class value_type {
+  BOOL,
+  INT,
+  INT64,
+  DOUBLE,
+  STRING_VIEW,
+  STRING,
+  STRING16
+};
+
+// Destination of a single column decoded by `read_fields`. The columns are
+// matched to the targets by position.
+struct column_target {
+  value_type type;
+  // Points to the value or, if |optional| is set, to a `std::optional` of it.
+  void* value;
+  bool optional;
+};
+
+namespace internal {
+
+template <class T>
+struct value_traits;
+
+template <>
+struct value_traits<bool> {
+  static constexpr value_type type = value_type::BOOL;
+  template <class FieldView>
+  static bool get(const FieldView& field) {
+    return field.as_bool();
+  }
+};
+
+template <>
+struct value_traits<int> {
+  static constexpr value_type type = value_type::INT;
+  template <class FieldView>
+  static int get(const FieldView& field) {
+    return field.as_int();
+  }
+};
+
+template <>
+struct value_traits<int64_t> {
+  static constexpr value_type type = value_type::INT64;
+  template <class FieldView>
+  static int64_t get(const FieldView& field) {
+    return field.as_int64();
+  }
+};
+
+template <>
+struct value_traits<double> {
+  static constexpr value_type type = value_type::DOUBLE;
+  template <class FieldView>
+  static double get(const FieldView& field) {
+    return field.as_double();
+  }
+};
+
+// Valid until the statement moves to the next row.
+template <>
+struct value_traits<std::string_view> {
+  static constexpr value_type type = value_type::STRING_VIEW;
+  template <class FieldView>
+  static std::string_view get(const FieldView& field) {
+    return field.as_string_view();
+  }
+};
+
+template <>
+struct value_traits<std::string> {
+  static constexpr value_type type = value_type::STRING;
+  template <class FieldView>
+  static std::string get(const FieldView& field) {
+    return field.as_string();
+  }
+};
+
+template <>
+struct value_traits<std::u16string> {
+  static constexpr value_type type = value_type::STRING16;
+  template <class FieldView>
+  static std::u16string get(const FieldView& field) {
+    return field.as_string16();
+  }
+};
+
+template <class T>
+struct row_value {
+  using type = T;
+  static constexpr bool optional = false;
+};
+
+template <class T>
+struct row_value<std::optional<T>> {
+  using type = T;
+  static constexpr bool optional = true;
+};
+
+template <class T>
+concept row_value_type =
+    requires { value_traits<typename row_value<T>::type>::type; };
+
+template <row_value_type T>
+column_target make_column_target(T& value) {
+  using traits = row_value<T>;
+  return {value_traits<typename traits::type>::type, &value, traits::optional};
+}
+
+// Calls `f(std::type_identity<T>{})` for the C++ type of |type|.
+template <class F>
+void visit_value_type(value_type type, F&& f) {
+  switch (type) {
+    case value_type::BOOL:
+      return f(std::type_identity<bool>{});
+    case value_type::INT:
+      return f(std::type_identity<int>{});
+    case value_type::INT64:
+      return f(std::type_identity<int64_t>{});
+    case value_type::DOUBLE:
+      return f(std::type_identity<double>{});
+    case value_type::STRING_VIEW:
+      return f(std::type_identity<std::string_view>{});
+    case value_type::STRING:
+      return f(std::type_identity<std::string>{});
+    case value_type::STRING16:
+      return f(std::type_identity<std::u16string>{});
+  }
+}
+
+// Decodes a driver field into |target|. NULL resets an optional target. The
+// drivers read NULL as a default value, so the type of a non-optional field
+// is not checked.
+template <class FieldView>
+void read_field(const FieldView& field, const column_target& target) {
+  visit_value_type(target.type, [&]<class T>(std::type_identity<T>) {
+    if (!target.optional) {
+      *static_cast<T*>(target.value) = value_traits<T>::get(field);
+      return;
+    }
+    auto& value = *static_cast<std::optional<T>*>(target.value);
+    if (field.type() == field_type::EMPTY)
+      value.reset();
+    else
+      value = value_traits<T>::get(field);
+  });
+}
+
+// The generic `read_fields` for drivers without a faster path.
+template <class Statement>
+void read_fields(const Statement& statement,
+                 std::span<const column_target> targets) {
+  for (size_t i = 0; i < targets.size(); ++i)
+    read_field(statement.at(static_cast<unsigned>(i)), targets[i]);
+}
+
+// Aggregate introspection. Only flat aggregates are supported: members that
+// are aggregates themselves are miscounted because of brace elision.
+
+struct any_member {
+  template <class T>
+  operator T() const;
+};
+
+template <class T, class... Members>
+constexpr size_t aggregate_size() {
+  if constexpr (requires { T{Members{}..., any_member{}}; })
+    return aggregate_size<T, Members..., any_member>();
+  else
+    return sizeof...(Members);
+}
+
+template <class T>
+concept tuple_like = requires { std::tuple_size<T>::value; };
+
+// Returns a tuple of references to the members of |row|, which is either a
+// tuple-like type or an aggregate of up to 16 members.
+template <class T>
+auto tie_members(T& row) {
+  if constexpr (tuple_like<T>) {
+    return std::apply([](auto&... members) { return std::tie(members...); },
+                      row);
+  } else {
+    static_assert(std::is_aggregate_v<T>, "Row must be an aggregate");
+    constexpr size_t size = aggregate_size<T>();
+    static_assert(size <= 16, "Row has too many members");
+    if constexpr (size == 1) {
+      auto& [m1] = row;
+      return std::tie(m1);
+    } else if constexpr (size == 2) {
+      auto& [m1, m2] = row;
+      return std::tie(m1, m2);
+    } else if constexpr (size == 3) {
+      auto& [m1, m2, m3] = row;
+      return std::tie(m1, m2, m3);
+    } else if constexpr (size == 4) {
+      auto& [m1, m2, m3, m4] = row;
+      return std::tie(m1, m2, m3, m4);
+    } else if constexpr (size == 5) {
+      auto& [m1, m2, m3, m4, m5] = row;
+      return std::tie(m1, m2, m3, m4, m5);
+    } else if constexpr (size == 6) {
+      auto& [m1, m2, m3, m4, m5, m6] = row;
+      return std::tie(m1, m2, m3, m4, m5, m6);
+    } else if constexpr (size == 7) {
+      auto& [m1, m2, m3, m4, m5, m6, m7] = row;
+      return std::tie(m1, m2, m3, m4, m5, m6, m7);
+    } else if constexpr (size == 8) {
+      auto& [m1, m2, m3, m4, m5, m6, m7, m8] = row;
+      return std::tie(m1, m2, m3, m4, m5, m6, m7, m8);
+    } else if constexpr (size == 9) {
+      auto& [m1, m2, m3, m4, m5, m6, m7, m8, m9] = row;
+      return std::tie(m1, m2, m3, m4, m5, m6, m7, m8, m9);
+    } else if constexpr (size == 10) {
+      auto& [m1, m2, m3, m4, m5, m6, m7, m8, m9, m10] = row;
+      return std::tie(m1, m2, m3, m4, m5, m6, m7, m8, m9, m10);
+    } else if constexpr (size == 11) {
+      auto& [m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11] = row;
+      return std::tie(m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11);
+    } else if constexpr (size == 12) {
+      auto& [m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12] = row;
+      return std::tie(m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12);
+    } else if constexpr (size == 13) {
+      auto& [m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13] = row;
+      return std::tie(m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13);
+    } else if constexpr (size == 14) {
+      auto& [m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14] =
+          row;
+      return std::tie(m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13,
+                      m14);
+    } else if constexpr (size == 15) {
+      auto& [m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14,
+             m15] = row;
+      return std::tie(m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13,
+                      m14, m15);
+    } else {
+      auto& [m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15,
+             m16] = row;
+      return std::tie(m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13,
+                      m14, m15, m16);
+    }
+  }
+}
+
+template <class Tuple>
+inline constexpr bool has_view_members = false;
+
+template <class... Members>
+inline constexpr bool has_view_members<std::tuple<Members&...>> =
+    (std::is_same_v<Members, std::string_view> || ...) ||
+    (std::is_same_v<Members, std::u16string_view> || ...);
+
+// Whether |Row| has members referring to the statement memory, which dangle
+// once the statement steps.
+template <class Row>
+inline constexpr bool has_view_members_v =
+    has_view_members<decltype(tie_members(std::declval<Row&>()))>;
+
+// Returns an array of targets for the members of |row|. It stays valid as
+// long as |row| does.
+template <class Row>
+auto make_column_targets(Row& row) {
+  return std::apply(
+      [](auto&... members) {
+        return std::array<column_target, sizeof...(members)>{
+            make_column_target(members)...};
+      },
+      tie_members(row));
+}
+
+// Decodes the current row of |statement| into the members of |row| with a
+// single `read_fields` call.
+template <class Statement, class Row>
+void read_row(const Statement& statement, Row& row) {
+  auto targets = make_column_targets(row);
+  statement.read_fields(targets);
+}
+
+}  // namespace internal
+
+}  // namespace sql
@@ -0,0 +1,280 @@
+#include "sql/sqlite3/bulk_load.h"
+
+#include "sql/exception.h"
+#include "sql/sqlite3/connection.h"
+
+#include <algorithm>
+#include <format>
+
+namespace sql::sqlite3 {
+
+namespace {
+
+const char kMarkerTableName[] = "sql_bulk_load";
+const char kStagingTableName[] = "sql_bulk_load_staging";
+
+std::string GetPragma(connection& connection, std::string_view name) {
+  statement statement{connection, std::format("PRAGMA {}", name)};
+  return statement.next() ? statement.at(0).as_string() : std::string{};
+}
+
+// Primary key columns in key order.
+std::vector<std::string> GetKeyColumns(connection& connection,
+                                       std::string_view table_name) {
+  statement table_info{connection,
+                       std::format("PRAGMA TABLE_INFO({})", table_name)};
+  std::vector<std::pair<int64_t, std::string>> key_columns;
+  while (table_info.next()) {
+    if (auto key_index = table_info.at(5).as_int64(); key_index > 0)
+      key_columns.emplace_back(key_index, table_info.at(1).as_string());
+  }
+  std::ranges::sort(key_columns);
+
+  std::vector<std::string> result;
+  for (auto& [key_index, name] : key_columns)
+    result.emplace_back(std::move(name));
+  return result;
+}
+
+int GetColumnCount(connection& connection, std::string_view table_name) {
+  statement table_info{connection,
+                       std::format("PRAGMA TABLE_INFO({})", table_name)};
+  int count = 0;
+  while (table_info.next())
+    ++count;
+  return count;
+}
+
+}  // namespace
+
+bulk_load::bulk_load(connection& connection,
+                     std::string_view table_name,
+                     const bulk_load_options& options)
+    : connection_{connection}, table_name_{table_name}, options_{options} {
+  journal_mode_ = GetPragma(connection_, "journal_mode");
+  synchronous_ = GetPragma(connection_, "synchronous");
+  cache_size_ = GetPragma(connection_, "cache_size");
+
+  // The marker must be durable before the journal is turned off.
+  connection_.start();
+  try {
+    SetMarker();
+    if (options_.drop_indexes)
+      DropIndexes();
+    connection_.commit();
+  } catch (...) {
+    connection_.rollback();
+    throw;
+  }
+
+  try {
+    connection_.query("PRAGMA journal_mode=OFF");
+    connection_.query("PRAGMA synchronous=OFF");
+    connection_.query(
+        std::format("PRAGMA cache_size=-{}", options_.cache_size_kib));
+
+    PrepareInsert();
+  } catch (...) {
+    // The destructor does not run. Nothing is inserted yet, so the indexes
+    // are rebuilt and the marker cleared.
+    try {
+      RestoreSettings();
+      recover(connection_, table_name_);
+    } catch (const Exception&) {
+    }
+    throw;
+  }
+}
+
+bulk_load::~bulk_load() {
+  if (finished_)
+    return;
+
+  try {
+    if (in_transaction_)
+      connection_.commit();
+    insert_statement_.close();
+    if (options_.sort_by_key)
+      connection_.query(std::format("DROP TABLE temp.{}", kStagingTableName));
+    RestoreSettings();
+  } catch (const Exception&) {
+  }
+}
+
+void bulk_load::SetMarker() {
+  connection_.query(
+      std::format("CREATE TABLE IF NOT EXISTS {}(table_name TEXT NOT NULL, "
+                  "index_name TEXT, index_sql TEXT)",
+                  kMarkerTableName));
+
+  statement insert{connection_,
+                   std::format("INSERT INTO {}(table_name) VALUES(?)",
+                               kMarkerTableName)};
+  insert.bind(0, table_name_);
+  insert.query();
+}
+
+void bulk_load::DropIndexes() {
+  // Only the indexes from CREATE INDEX can be dropped.
+  std::vector<std::string> index_names;
+  {
+    statement index_list{connection_,
+                         std::format("PRAGMA INDEX_LIST({})", table_name_)};
+    while (index_list.next()) {
+      if (index_list.at(3).as_string_view() == "c")
+        index_names.emplace_back(index_list.at(1).as_string());
+    }
+  }
+
+  statement select_sql{
+      connection_, "SELECT sql FROM sqlite_master WHERE type='index' AND name=?"};
+  statement insert{connection_,
+                   std::format("INSERT INTO {} VALUES(?, ?, ?)",
+                               kMarkerTableName)};
+
+  for (const auto& index_name : index_names) {
+    select_sql.bind(0, index_name);
+    if (!select_sql.next())
+      throw Exception{std::format("Index {} not found", index_name)};
+    insert.bind(0, table_name_);
+    insert.bind(1, index_name);
+    insert.bind(2, select_sql.at(0).as_string_view());
+    insert.query();
+    insert.reset();
+    select_sql.reset();
+
+    connection_.query(std::format("DROP INDEX {}", index_name));
+  }
+}
+
+void bulk_load::PrepareInsert() {
+  auto target = table_name_;
+  if (options_.sort_by_key) {
+    // Copies the column names without any constraint or index.
+    connection_.query(
+        std::format("CREATE TEMP TABLE {} AS SELECT * FROM main.{} WHERE 0",
+                    kStagingTableName, table_name_));
+    target = std::format("temp.{}", kStagingTableName);
+  }
+
+  std::string placeholders;
+  for (int i = GetColumnCount(connection_, table_name_); i > 0; --i)
+    placeholders += i > 1 ? "?, " : "?";
+
+  insert_statement_.prepare(
+      connection_,
+      std::format("INSERT INTO {} VALUES({})", target, placeholders));
+}
+
+void bulk_load::InsertRow() {
+  if (!in_transaction_) {
+    connection_.start();
+    in_transaction_ = true;
+  }
+
+  insert_statement_.query();
+  insert_statement_.reset();
+
+  if (++row_count_ % options_.batch_size == 0) {
+    connection_.commit();
+    in_transaction_ = false;
+  }
+}
+
+void bulk_load::InsertSortedRows() {
+  auto key_columns = GetKeyColumns(connection_, table_name_);
+
+  std::string order_by;
+  for (const auto& column : key_columns)
+    order_by += order_by.empty() ? " ORDER BY " + column : ", " + column;
+
+  connection_.start();
+  connection_.query(std::format("INSERT INTO main.{} SELECT * FROM temp.{}{}",
+                                table_name_, kStagingTableName, order_by));
+  connection_.commit();
+
+  connection_.query(std::format("DROP TABLE temp.{}", kStagingTableName));
+}
+
+void bulk_load::finish() {
+  if (in_transaction_) {
+    connection_.commit();
+    in_transaction_ = false;
+  }
+
+  insert_statement_.close();
+
+  if (options_.sort_by_key)
+    InsertSortedRows();
+
+  // The marker may only be cleared once everything is synced.
+  RestoreSettings();
+  recover(connection_, table_name_);
+
+  finished_ = true;
+}
+
+void bulk_load::RestoreSettings() {
+  connection_.query(std::format("PRAGMA journal_mode={}", journal_mode_));
+  connection_.query(std::format("PRAGMA synchronous={}", synchronous_));
+  connection_.query(std::format("PRAGMA cache_size={}", cache_size_));
+}
+
+// static
+std::vector<std::string> bulk_load::interrupted_tables(
+    connection& connection) {
+  std::vector<std::string> table_names;
+  if (!connection.table_exists(kMarkerTableName))
+    return table_names;
+
+  statement select{
+      connection,
+      std::format("SELECT table_name FROM {} WHERE index_name IS NULL",
+                  kMarkerTableName)};
+  while (select.next())
+    table_names.emplace_back(select.at(0).as_string());
+  return table_names;
+}
+
+// static
+void bulk_load::recover(connection& connection, std::string_view table_name) {
+  if (!connection.table_exists(kMarkerTableName))
+    return;
+
+  std::vector<std::pair<std::string, std::string>> indexes;
+  {
+    statement select{
+        connection,
+        std::format("SELECT index_name, index_sql FROM {} "
+                    "WHERE table_name=? AND index_name IS NOT NULL",
+                    kMarkerTableName)};
+    select.bind(0, table_name);
+    while (select.next()) {
+      indexes.emplace_back(select.at(0).as_string(),
+                           select.at(1).as_string());
+    }
+  }
+
+  connection.start();
+  try {
+    // A previous recovery may have rebuilt some of them.
+    for (const auto& [index_name, index_sql] : indexes) {
+      if (!connection.index_exists(table_name, index_name))
+        connection.query(index_sql);
+    }
+
+    connection.query(std::format("ANALYZE {}", table_name));
+
+    statement clear{connection, std::format("DELETE FROM {} WHERE table_name=?",
+                                            kMarkerTableName)};
+    clear.bind(0, table_name);
+    clear.query();
+
+    connection.commit();
+  } catch (...) {
+    connection.rollback();
+    throw;
+  }
+}
+
+}  // namespace sql::sqlite3
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "sql/sqlite3/statement.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace sql::sqlite3 {
+
+class connection;
+
+struct bulk_load_options {
+  // Rows per transaction.
+  int64_t batch_size = 100'000;
+  // In KiB.
+  int cache_size_kib = 1024 * 1024;
+  // Drops the indexes created by CREATE INDEX and rebuilds them once all rows
+  // are inserted. Indexes of UNIQUE constraints cannot be dropped.
+  bool drop_indexes = true;
+  // Stages the rows in a temporary table and inserts them in primary key
+  // order, so pages are filled sequentially. Costs writing the data twice.
+  bool sort_by_key = false;
+};
+
+// Fast insertion of many rows into a single table. While it lasts, the
+// connection runs without a rollback journal and without syncs, so a crash
+// may corrupt the database. An interrupted load is detected by a marker kept
+// in the `sql_bulk_load` table, which also records the dropped indexes.
+//
+// The connection must not be used for anything else meanwhile.
+class bulk_load {
+ public:
+  bulk_load(connection& connection,
+            std::string_view table_name,
+            const bulk_load_options& options = {});
+  // Without `finish`, commits the inserted rows and restores the connection
+  // settings, but leaves the indexes dropped and the marker set. Rows staged
+  // for sorting are discarded.
+  ~bulk_load();
+
+  bulk_load(const bulk_load&) = delete;
+  bulk_load& operator=(const bulk_load&) = delete;
+
+  // Inserts a row with a value for every column, in table order. Empty
+  // optionals are bound as NULL.
+  template <class... Args>
+  void insert(const Args&... values);
+
+  int64_t row_count() const { return row_count_; }
+
+  // Commits the rows, rebuilds the indexes, runs ANALYZE, restores the
+  // connection settings and clears the marker.
+  void finish();
+
+  // Tables with a load that did not finish, e.g. because of a crash.
+  static std::vector<std::string> interrupted_tables(connection& connection);
+
+  // Rebuilds the indexes dropped by an interrupted load of |table_name| and
+  // clears its marker. Check the database with `PRAGMA integrity_check` first
+  // if the load was interrupted by a crash.
+  static void recover(connection& connection, std::string_view table_name);
+
+ private:
+  template <class T>
+  void Bind(unsigned column, const T& value);
+  template <class T>
+  void Bind(unsigned column, const std::optional<T>& value);
+
+  void SetMarker();
+  void DropIndexes();
+  void PrepareInsert();
+  void InsertRow();
+  void InsertSortedRows();
+  void RestoreSettings();
+
+  connection& connection_;
+  const std::string table_name_;
+  const bulk_load_options options_;
+
+  // Settings restored after the load.
+  std::string journal_mode_;
+  std::string synchronous_;
+  std::string cache_size_;
+
+  statement insert_statement_;
+  bool in_transaction_ = false;
+  bool finished_ = false;
+  int64_t row_count_ = 0;
+};
+
+template <class... Args>
+inline void bulk_load::insert(const Args&... values) {
+  unsigned column = 0;
+  (Bind(column++, values), ...);
+  InsertRow();
+}
+
+template <class T>
+inline void bulk_load::Bind(unsigned column, const T& value) {
+  insert_statement_.bind(column, value);
+}
+
+template <class T>
+inline void bulk_load::Bind(unsigned column, const std::optional<T>& value) {
+  if (value)
+    insert_statement_.bind(column, *value);
+  else
+    insert_statement_.bind_null(column);
+}
+
+}  // namespace sql::sqlite3
@@ -0,0 +1,108 @@
+#include "sql/sqlite3/bulk_load.h"
+
+#include "sql/exception.h"
+#include "sql/sqlite3/connection.h"
+#include "sql/test/temp_dir.h"
+
+#include <gmock/gmock.h>
+
+using namespace testing;
+
+namespace sql::sqlite3 {
+
+namespace {
+
+constexpr int kRowCount = 10'000;
+
+class BulkLoadTest : public TestWithParam<bool> {
+ public:
+  void SetUp() override {
+    connection_.open({.path = temp_dir_.get() / "database.sqlite3",
+                      .journal = journal_mode::WAL});
+    connection_.query(
+        "CREATE TABLE t(id INTEGER PRIMARY KEY, name TEXT, value REAL)");
+    connection_.query("CREATE INDEX t_name ON t(name)");
+  }
+
+  void Load(bulk_load& load) {
+    for (int i = 0; i < kRowCount; ++i) {
+      // Out of key order.
+      int id = (i * 7919) % kRowCount;
+      load.insert(id, std::format("name {}", id),
+                  id % 2 ? std::optional<double>{id * 0.5} : std::nullopt);
+    }
+  }
+
+  std::string GetPragma(std::string_view name) {
+    statement statement{connection_, std::format("PRAGMA {}", name)};
+    EXPECT_TRUE(statement.next());
+    return statement.at(0).as_string();
+  }
+
+  int64_t Count(std::string_view sql) {
+    statement statement{connection_, sql};
+    EXPECT_TRUE(statement.next());
+    return statement.at(0).as_int64();
+  }
+
+ protected:
+  ScopedTempDir temp_dir_;
+  connection connection_;
+};
+
+}  // namespace
+
+TEST_P(BulkLoadTest, Load) {
+  bulk_load load{connection_, "t",
+                 {.batch_size = 1000, .sort_by_key = GetParam()}};
+  EXPECT_EQ(GetPragma("journal_mode"), "off");
+  EXPECT_FALSE(connection_.index_exists("t", "t_name"));
+  EXPECT_THAT(bulk_load::interrupted_tables(connection_), ElementsAre("t"));
+
+  Load(load);
+  load.finish();
+
+  EXPECT_EQ(load.row_count(), kRowCount);
+  EXPECT_EQ(Count("SELECT COUNT(*) FROM t"), kRowCount);
+  EXPECT_EQ(Count("SELECT COUNT(value) FROM t"), kRowCount / 2);
+  EXPECT_EQ(GetPragma("journal_mode"), "wal");
+  EXPECT_TRUE(connection_.index_exists("t", "t_name"));
+  EXPECT_THAT(bulk_load::interrupted_tables(connection_), IsEmpty());
+  EXPECT_GT(Count("SELECT COUNT(*) FROM sqlite_stat1 WHERE tbl='t'"), 0);
+}
+
+TEST_P(BulkLoadTest, Interrupted) {
+  {
+    bulk_load load{connection_, "t",
+                   {.batch_size = 1000, .sort_by_key = GetParam()}};
+    Load(load);
+  }
+
+  EXPECT_EQ(GetPragma("journal_mode"), "wal");
+  EXPECT_FALSE(connection_.index_exists("t", "t_name"));
+  EXPECT_THAT(bulk_load::interrupted_tables(connection_), ElementsAre("t"));
+
+  bulk_load::recover(connection_, "t");
+  EXPECT_TRUE(connection_.index_exists("t", "t_name"));
+  EXPECT_THAT(bulk_load::interrupted_tables(connection_), IsEmpty());
+}
+
+TEST_P(BulkLoadTest, RestoresOnFailure) {
+  // Fails the preparation of the insertion once the journal is turned off.
+  connection_.query(GetParam()
+                        ? "CREATE TEMP TABLE sql_bulk_load_staging(x)"
+                        : "CREATE TEMP VIEW t2 AS SELECT 1");
+  auto synchronous = GetPragma("synchronous");
+  bulk_load_options options{.sort_by_key = GetParam()};
+  EXPECT_THROW(bulk_load(connection_, GetParam() ? "t" : "t2", options),
+               Exception);
+
+  EXPECT_EQ(GetPragma("journal_mode"), "wal");
+  EXPECT_EQ(GetPragma("synchronous"), synchronous);
+  EXPECT_TRUE(connection_.index_exists("t", "t_name"));
+  EXPECT_THAT(bulk_load::interrupted_tables(connection_), IsEmpty());
+}
+
+INSTANTIATE_TEST_SUITE_P(SortByKey, BulkLoadTest, Bool());
+
+}  // namespace sql::sqlite3
@@ -0,0 +1,108 @@
+#include "sql/sqlite3/change_feed.h"
+
+#include "sql/sqlite3/connection.h"
+
+#include <cassert>
+#include <iterator>
+#include <sqlite3.h>
+
+namespace sql::sqlite3 {
+
+change_feed::change_feed(connection& connection, size_t capacity)
+    : connection_{connection}, queue_{capacity} {
+  ::sqlite3* db = connection_.native_handle();
+  assert(db);
+
+  sqlite3_update_hook(
+      db,
+      [](void* context, int operation, const char* database_name,
+         const char* table_name, sqlite3_int64 rowid) {
+        UpdateHook(context, operation, database_name, table_name, rowid);
+      },
+      this);
+  sqlite3_commit_hook(db, &change_feed::CommitHook, this);
+  sqlite3_rollback_hook(db, &change_feed::RollbackHook, this);
+  sqlite3_trace_v2(db, SQLITE_TRACE_STMT | SQLITE_TRACE_PROFILE,
+                   &change_feed::TraceHook, this);
+}
+
+change_feed::~change_feed() {
+  ::sqlite3* db = connection_.native_handle();
+  sqlite3_update_hook(db, nullptr, nullptr);
+  sqlite3_commit_hook(db, nullptr, nullptr);
+  sqlite3_rollback_hook(db, nullptr, nullptr);
+  sqlite3_trace_v2(db, 0, nullptr, nullptr);
+}
+
+// static
+void change_feed::UpdateHook(void* context,
+                             int operation,
+                             const char* database_name,
+                             const char* table_name,
+                             int64_t rowid) {
+  auto& feed = *static_cast<change_feed*>(context);
+  try {
+    feed.pending_events_.emplace_back(change_event{
+        .database_name = database_name,
+        .table_name = table_name,
+        .operation = operation == SQLITE_INSERT   ? change_operation::INSERT
+                     : operation == SQLITE_UPDATE ? change_operation::UPDATE
+                                                  : change_operation::DELETE,
+        .rowid = rowid});
+  } catch (...) {
+    feed.pending_events_lost_ = true;
+  }
+}
+
+// static
+int change_feed::CommitHook(void* context) {
+  auto& feed = *static_cast<change_feed*>(context);
+  // Nonzero turns the commit into a rollback.
+  if (feed.pending_events_lost_)
+    return 1;
+
+  // The commit may still fail, so the events are published once it completes.
+  try {
+    feed.committed_events_.insert(
+        feed.committed_events_.end(),
+        std::make_move_iterator(feed.pending_events_.begin()),
+        std::make_move_iterator(feed.pending_events_.end()));
+  } catch (...) {
+    return 1;
+  }
+  feed.pending_events_.clear();
+  return 0;
+}
+
+// static
+void change_feed::RollbackHook(void* context) {
+  auto& feed = *static_cast<change_feed*>(context);
+  feed.pending_events_.clear();
+  feed.pending_events_lost_ = false;
+  feed.committed_events_.clear();
+}
+
+// static
+int change_feed::TraceHook(unsigned /*type*/,
+                           void* context,
+                           void* /*statement*/,
+                           void* /*elapsed*/) {
+  auto& feed = *static_cast<change_feed*>(context);
+  if (feed.committed_events_.empty() ||
+      !sqlite3_get_autocommit(feed.connection_.native_handle())) {
+    return 0;
+  }
+
+  // Events that fail to publish are retried after the next statement.
+  auto& events = feed.committed_events_;
+  auto published = events.begin();
+  try {
+    for (; published != events.end(); ++published)
+      feed.queue_.push(*published);
+  } catch (...) {
+  }
+  events.erase(events.begin(), published);
+  return 0;
+}
+
+}  // namespace sql::sqlite3
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "sql/concurrent_queue.h"
+#include "sql/sqlite3/change_operation.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace sql::sqlite3 {
+
+class connection;
+
+struct change_event {
+  // The schema of the table, e.g. `main`, `temp` or an attached database.
+  std::string database_name;
+  std::string table_name;
+  change_operation operation;
+  int64_t rowid;
+};
+
+// Reports the rows changed through a connection, e.g. to invalidate caches.
+// Events of a transaction are buffered and only published once the statement
+// that commits it completes, so consumers never see changes that are rolled
+// back or not yet durable. If an event cannot be buffered, the commit fails
+// rather than the event being lost. Any number of consumer threads can drain
+// the feed.
+//
+// Built on the SQLite update hook, which does not report changes of WITHOUT
+// ROWID tables, rows replaced by ON CONFLICT REPLACE and rows removed by the
+// truncate optimization. Changes undone by ROLLBACK TO a savepoint are still
+// reported. A connection supports a single feed, which also takes over its
+// `sqlite3_trace_v2` callback.
+class change_feed {
+ public:
+  explicit change_feed(connection& connection, size_t capacity = 1024);
+  ~change_feed();
+
+  change_feed(const change_feed&) = delete;
+  change_feed& operator=(const change_feed&) = delete;
+
+  std::optional<change_event> try_pop() { return queue_.try_pop(); }
+  change_event wait_pop() { return queue_.wait_pop(); }
+  bool empty() const { return queue_.empty(); }
+
+ private:
+  static void UpdateHook(void* context,
+                         int operation,
+                         const char* database_name,
+                         const char* table_name,
+                         int64_t rowid);
+  static int CommitHook(void* context);
+  static void RollbackHook(void* context);
+  // Publishes the committed events once a statement completes outside of a
+  // transaction. A COMMIT statement resumed without a reset after a failure
+  // does not report its completion, so the next statement starting also
+  // publishes them.
+  static int TraceHook(unsigned type,
+                       void* context,
+                       void* statement,
+                       void* elapsed);
+
+  connection& connection_;
+
+  // Events of the current transaction.
+  std::vector<change_event> pending_events_;
+  // Set if an event of the current transaction could not be buffered.
+  bool pending_events_lost_ = false;
+
+  // Events of the transaction being committed.
+  std::vector<change_event> committed_events_;
+
+  concurrent_queue<change_event> queue_;
+};
+
+}  // namespace sql::sqlite3
@@ -0,0 +1,129 @@
+#include "sql/sqlite3/change_feed.h"
+
+#include "sql/exception.h"
+#include "sql/sqlite3/connection.h"
+#include "sql/sqlite3/statement.h"
+#include "sql/test/temp_dir.h"
+
+#include <format>
+#include <gmock/gmock.h>
+#include <thread>
+
+using namespace testing;
+
+namespace sql::sqlite3 {
+
+namespace {
+
+std::vector<std::string> Drain(change_feed& feed) {
+  std::vector<std::string> events;
+  while (auto event = feed.try_pop()) {
+    events.emplace_back(std::format("{} {} {}", event->table_name,
+                                    static_cast<int>(event->operation),
+                                    event->rowid));
+  }
+  return events;
+}
+
+}  // namespace
+
+TEST(ChangeFeedTest, PublishesOnCommit) {
+  connection connection;
+  connection.open({});
+  connection.query("CREATE TABLE t(id INTEGER PRIMARY KEY, v TEXT)");
+
+  change_feed feed{connection};
+
+  connection.start();
+  connection.query("INSERT INTO t VALUES(1, 'a'), (2, 'b')");
+  connection.query("UPDATE t SET v = 'c' WHERE id = 2");
+  connection.query("DELETE FROM t WHERE id = 1");
+  EXPECT_TRUE(feed.empty());
+  connection.commit();
+
+  EXPECT_THAT(Drain(feed), ElementsAre("t 0 1", "t 0 2", "t 1 2", "t 2 1"));
+
+  // Rolled back changes are dropped.
+  connection.start();
+  connection.query("INSERT INTO t VALUES(3, 'd')");
+  connection.rollback();
+  EXPECT_TRUE(feed.empty());
+
+  // Statements outside of a transaction commit on their own.
+  connection.query("INSERT INTO t VALUES(4, 'e')");
+  EXPECT_THAT(Drain(feed), ElementsAre("t 0 4"));
+}
+
+TEST(ChangeFeedTest, ReportsDatabaseName) {
+  connection connection;
+  connection.open({});
+  connection.query("ATTACH DATABASE ':memory:' AS aux");
+  connection.query("CREATE TABLE main.t(id INTEGER PRIMARY KEY)");
+  connection.query("CREATE TABLE aux.t(id INTEGER PRIMARY KEY)");
+
+  change_feed feed{connection};
+
+  connection.query("INSERT INTO main.t VALUES(1)");
+  connection.query("INSERT INTO aux.t VALUES(1)");
+
+  std::vector<std::string> events;
+  while (auto event = feed.try_pop()) {
+    events.emplace_back(
+        std::format("{}.{} {}", event->database_name, event->table_name,
+                    event->rowid));
+  }
+  EXPECT_THAT(events, ElementsAre("main.t 1", "aux.t 1"));
+}
+
+TEST(ChangeFeedTest, PublishesOnlyAfterCommitSucceeds) {
+  ScopedTempDir temp_dir;
+  auto path = temp_dir.get() / "database.sqlite3";
+
+  connection connection;
+  connection.open({.path = path});
+  connection.query("CREATE TABLE t(id INTEGER PRIMARY KEY)");
+
+  change_feed feed{connection};
+
+  // The reader's lock makes the commit fail after the commit hook.
+  sql::sqlite3::connection reader;
+  reader.open({.path = path});
+  reader.start();
+  statement select{reader, "SELECT COUNT(*) FROM t"};
+  ASSERT_TRUE(select.next());
+
+  connection.start();
+  connection.query("INSERT INTO t VALUES(1)");
+  EXPECT_THROW(connection.commit(), Exception);
+  EXPECT_TRUE(feed.empty());
+
+  select.reset();
+  reader.commit();
+
+  connection.commit();
+  EXPECT_THAT(Drain(feed), ElementsAre("t 0 1"));
+}
+
+TEST(ChangeFeedTest, ConsumerThread) {
+  constexpr int kRowCount = 1000;
+
+  connection connection;
+  connection.open({});
+  connection.query("CREATE TABLE t(id INTEGER PRIMARY KEY)");
+
+  change_feed feed{connection};
+
+  int64_t rowid_sum = 0;
+  std::thread consumer{[&feed, &rowid_sum] {
+    for (int i = 0; i < kRowCount; ++i)
+      rowid_sum += feed.wait_pop().rowid;
+  }};
+
+  for (int i = 1; i <= kRowCount; ++i)
+    connection.query(std::format("INSERT INTO t VALUES({})", i));
+
+  consumer.join();
+  EXPECT_EQ(rowid_sum, kRowCount * (kRowCount + 1) / 2);
+}
+
+}  // namespace sql::sqlite3
@@ -0,0 +1,8 @@
+#pragma once
+
+namespace sql::sqlite3 {
+
+// The kind of a row change reported by `session` and `change_feed`.
+enum class change_operation { INSERT, UPDATE, DELETE };
+
+}  // namespace sql::sqlite3
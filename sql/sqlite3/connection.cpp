@@ -1,15 +1,168 @@
 #include "sql/sqlite3/connection.h"
 
 #include "sql/exception.h"
+#include "sql/sqlite3/memory.h"
 #include "sql/sqlite3/sqlite_util.h"
 #include "sql/sqlite3/statement.h"
 
+#include <algorithm>
 #include <cassert>
+#include <charconv>
+#include <chrono>
+#include <filesystem>
 #include <format>
+#include <random>
+#include <span>
 #include <sqlite3.h>
+#include <thread>
+#include <utility>
 
 namespace sql::sqlite3 {
 
+namespace {
+
+const char* GetBeginTransactionSql(transaction_mode mode) {
+  switch (mode) {
+    case transaction_mode::IMMEDIATE:
+      return "BEGIN IMMEDIATE TRANSACTION";
+    case transaction_mode::EXCLUSIVE:
+      return "BEGIN EXCLUSIVE TRANSACTION";
+    default:
+      return "BEGIN TRANSACTION";
+  }
+}
+
+// Fills the tuning fields not set explicitly from the profile.
+void ApplyProfile(open_params& params) {
+  auto set = [](auto& field, auto value) {
+    if (!field)
+      field = value;
+  };
+
+  switch (params.profile) {
+    case performance_profile::DURABLE_OLTP:
+      set(params.journal, journal_mode::WAL);
+      set(params.synchronous, synchronous_mode::FULL);
+      set(params.cache_size, -32 * 1024);
+      set(params.mmap_size, int64_t{256} << 20);
+      break;
+    case performance_profile::BULK_LOAD:
+      set(params.journal, journal_mode::WAL);
+      set(params.synchronous, synchronous_mode::OFF);
+      set(params.cache_size, -256 * 1024);
+      set(params.temp_store, temp_store_mode::MEMORY);
+      break;
+    case performance_profile::READ_ONLY_ANALYTICS:
+      set(params.cache_size, -128 * 1024);
+      set(params.mmap_size, int64_t{1} << 30);
+      set(params.temp_store, temp_store_mode::MEMORY);
+      set(params.worker_threads, 4);
+      break;
+    default:
+      break;
+  }
+}
+
+// Escapes the characters that have a meaning in SQLite URIs.
+std::string GetFileUri(std::string_view path) {
+  std::string uri = "file:";
+#if defined(_WIN32)
+  // Drive letters need a leading slash.
+  if (path.size() >= 2 && path[1] == ':')
+    uri += '/';
+#endif
+  for (char c : path) {
+    if (c == '%' || c == '?' || c == '#') {
+      constexpr char kHexDigits[] = "0123456789ABCDEF";
+      uri += '%';
+      uri += kHexDigits[(c >> 4) & 0xF];
+      uri += kHexDigits[c & 0xF];
+    }
+#if defined(_WIN32)
+    else if (c == '\\')
+      uri += '/';
+#endif
+    else
+      uri += c;
+  }
+  return uri;
+}
+
+const char* GetJournalModeName(journal_mode mode) {
+  switch (mode) {
+    case journal_mode::DELETE:
+      return "DELETE";
+    case journal_mode::TRUNCATE:
+      return "TRUNCATE";
+    case journal_mode::PERSIST:
+      return "PERSIST";
+    case journal_mode::MEMORY:
+      return "MEMORY";
+    case journal_mode::WAL:
+      return "WAL";
+    case journal_mode::OFF:
+      return "OFF";
+  }
+  assert(false);
+  return "DELETE";
+}
+
+struct PlanRow {
+  int id = 0;
+  int parent = 0;
+  std::string detail;
+};
+
+std::vector<query_plan_node> BuildPlanNodes(std::span<const PlanRow> rows,
+                                            int parent) {
+  std::vector<query_plan_node> nodes;
+  for (auto& row : rows) {
+    if (row.parent == parent) {
+      auto& node = nodes.emplace_back(query_plan_node{.detail = row.detail});
+      node.children = BuildPlanNodes(rows, row.id);
+    }
+  }
+  return nodes;
+}
+
+// Parses the table name out of "SCAN t ..." or "SEARCH t ..." lines. Returns
+// an empty string for subqueries and constant rows.
+std::string_view ParsePlanTable(std::string_view detail, bool& full_scan) {
+  constexpr std::string_view kScan = "SCAN ";
+  constexpr std::string_view kSearch = "SEARCH ";
+
+  full_scan = detail.starts_with(kScan);
+  if (full_scan)
+    detail.remove_prefix(kScan.size());
+  else if (detail.starts_with(kSearch))
+    detail.remove_prefix(kSearch.size());
+  else
+    return {};
+
+  // Before SQLite 3.36.
+  if (detail.starts_with("TABLE "))
+    detail.remove_prefix(6);
+
+  auto table = detail.substr(0, detail.find(' '));
+  if (table.empty() || table.starts_with('(') || table == "CONSTANT") {
+    full_scan = false;
+    return {};
+  }
+
+  return table;
+}
+
+void ParsePlanTables(std::vector<query_plan_node>& nodes) {
+  for (auto& node : nodes) {
+    node.table = ParsePlanTable(node.detail, node.full_scan);
+    ParsePlanTables(node.children);
+  }
+}
+
+}  // namespace
+
+connection::connection() = default;
+
 connection::connection(const open_params& params) {
   open(params);
 }
@@ -21,18 +174,29 @@ connection::~connection() {
 void connection::open(const open_params& params) {
   assert(!db_);
 
-  int flags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE;
+  int flags = params.read_only || params.immutable
+                  ? SQLITE_OPEN_READONLY
+                  : SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE;
   if (params.multithreaded)
     flags |= SQLITE_OPEN_NOMUTEX;
 
-  int error = sqlite3_open_v2(
-      reinterpret_cast<const char*>(params.path.u8string().c_str()), &db_,
-      flags, nullptr);
+  auto path = params.path.u8string();
+  std::string filename{reinterpret_cast<const char*>(path.data()),
+                       path.size()};
+  if (params.immutable) {
+    flags |= SQLITE_OPEN_URI;
+    filename = GetFileUri(filename) + "?mode=ro&immutable=1";
+  }
+
+  int error = sqlite3_open_v2(filename.c_str(), &db_, flags,
+                              params.vfs.empty() ? nullptr : params.vfs.c_str());
   if (error != SQLITE_OK) {
     db_ = nullptr;
     throw Exception{"open error"};
   }
 
+  internal::register_connection(db_);
+
   if (params.exclusive_locking)
     query("PRAGMA locking_mode=EXCLUSIVE");
 
@@ -40,10 +204,63 @@ void connection::open(const open_params& params) {
     query(
         std::format("PRAGMA journal_size_limit={}", params.journal_size_limit));
   }
+
+  if (params.busy_timeout >= 0) {
+    busy_timeout_ = params.busy_timeout;
+    sqlite3_busy_handler(db_, &connection::BusyHandler, this);
+  }
+
+  full_scan_handler_ = params.full_scan_handler;
+  full_scan_row_threshold_ = params.full_scan_row_threshold;
+
+  ApplyTuning(params);
+}
+
+void connection::ApplyTuning(open_params params) {
+  ApplyProfile(params);
+
+  if (params.immutable && !params.mmap_size) {
+    std::error_code ec;
+    auto file_size = std::filesystem::file_size(params.path, ec);
+    if (!ec)
+      params.mmap_size = static_cast<int64_t>(file_size);
+  }
+
+  // Both write to the database.
+  bool read_only = params.read_only || params.immutable;
+
+  // The page size must be set before the journal mode switches to WAL.
+  if (params.page_size && !read_only)
+    query(std::format("PRAGMA page_size={}", *params.page_size));
+
+  if (params.journal && !read_only) {
+    query(std::format("PRAGMA journal_mode={}",
+                      GetJournalModeName(*params.journal)));
+  }
+
+  if (params.synchronous) {
+    query(std::format("PRAGMA synchronous={}",
+                      static_cast<int>(*params.synchronous)));
+  }
+
+  if (params.cache_size)
+    query(std::format("PRAGMA cache_size={}", *params.cache_size));
+
+  if (params.mmap_size)
+    query(std::format("PRAGMA mmap_size={}", *params.mmap_size));
+
+  if (params.temp_store) {
+    query(std::format("PRAGMA temp_store={}",
+                      static_cast<int>(*params.temp_store)));
+  }
+
+  if (params.worker_threads)
+    query(std::format("PRAGMA threads={}", *params.worker_threads));
 }
 
 void connection::close() {
-  begin_transaction_statement_.reset();
+  std::ranges::for_each(begin_transaction_statements_,
+                        [](auto& statement) { statement.reset(); });
   commit_transaction_statement_.reset();
   rollback_transaction_statement_.reset();
   does_table_exist_statement_.reset();
@@ -51,7 +268,9 @@ void connection::close() {
   does_index_exist_statement_.reset();
 
   if (db_) {
+    internal::unregister_connection(db_);
     if (sqlite3_close(db_) != SQLITE_OK) {
+      internal::register_connection(db_);
       const char* message = sqlite3_errmsg(db_);
       throw Exception{message};
     }
@@ -68,6 +287,20 @@ void connection::query(std::string_view sql) {
   }
 }
 
+std::string connection::key_set_sql(std::string_view sql,
+                                    size_t key_count) const {
+  // Expands the placeholder into a parameter per key.
+  auto pos = sql::internal::FindKeySetPlaceholder(sql);
+  std::string result{sql.substr(0, pos)};
+  result.reserve(sql.size() + key_count * 2);
+  result += "IN (";
+  for (size_t i = 0; i < key_count; ++i)
+    result += i == 0 ? "?" : ",?";
+  result += ')';
+  result += sql.substr(pos + sql::internal::kKeySetPlaceholder.size());
+  return result;
+}
+
 bool connection::table_exists(std::string_view table_name) const {
   if (!does_table_exist_statement_) {
     does_table_exist_statement_ = std::make_unique<statement>(
@@ -132,13 +365,19 @@ bool connection::index_exists(std::string_view table_name,
 }
 
 void connection::start() {
-  if (!begin_transaction_statement_) {
-    begin_transaction_statement_ =
-        std::make_unique<statement>(*this, "BEGIN TRANSACTION");
+  start(transaction_options{});
+}
+
+void connection::start(const transaction_options& options) {
+  auto& begin_transaction_statement =
+      begin_transaction_statements_[static_cast<size_t>(options.mode)];
+  if (!begin_transaction_statement) {
+    begin_transaction_statement = std::make_unique<statement>(
+        *this, GetBeginTransactionSql(options.mode));
   }
 
-  begin_transaction_statement_->query();
-  begin_transaction_statement_->reset();
+  begin_transaction_statement->query();
+  begin_transaction_statement->reset();
 }
 
 void connection::commit() {
@@ -147,8 +386,16 @@ void connection::commit() {
         std::make_unique<statement>(*this, "COMMIT");
   }
 
-  commit_transaction_statement_->query();
-  commit_transaction_statement_->reset();
+  // A failed commit, e.g. a busy one, leaves the transaction active. The
+  // statement is reset either way, so that a retry runs it from the start.
+  auto& statement = *commit_transaction_statement_;
+  try {
+    statement.query();
+  } catch (...) {
+    statement.reset();
+    throw;
+  }
+  statement.reset();
 }
 
 void connection::rollback() {
@@ -161,6 +408,42 @@ void connection::rollback() {
   rollback_transaction_statement_->reset();
 }
 
+void connection::savepoint(std::string_view name) {
+  query(std::format("SAVEPOINT {}", name));
+}
+
+void connection::release_savepoint(std::string_view name) {
+  query(std::format("RELEASE SAVEPOINT {}", name));
+}
+
+void connection::rollback_to_savepoint(std::string_view name) {
+  query(std::format("ROLLBACK TO SAVEPOINT {}", name));
+}
+
+// static
+int connection::BusyHandler(void* data, int count) {
+  auto& connection = *static_cast<sql::sqlite3::connection*>(data);
+
+  // |count| restarts from zero for every new lock wait.
+  if (count == 0)
+    connection.busy_waited_ = 0;
+
+  if (connection.busy_waited_ >= connection.busy_timeout_)
+    return 0;
+
+  // Exponential backoff with jitter, so that waiting writers don't retry in
+  // lockstep.
+  constexpr int kMaxDelayMs = 100;
+  thread_local std::minstd_rand random{std::random_device{}()};
+  int delay = std::min(1 << std::min(count, 7), kMaxDelayMs);
+  delay = std::uniform_int_distribution<>{delay / 2 + 1, delay}(random);
+  delay = std::min(delay, connection.busy_timeout_ - connection.busy_waited_);
+
+  std::this_thread::sleep_for(std::chrono::milliseconds{delay});
+  connection.busy_waited_ += delay;
+  return 1;
+}
+
 int connection::last_change_count() const {
   assert(db_);
   return sqlite3_changes(db_);
@@ -184,4 +467,128 @@ std::vector<field_info> connection::table_fields(
   return fields;
 }
 
+connection_status connection::status(bool reset) const {
+  assert(db_);
+
+  auto get = [this, reset](int op) {
+    int current = 0;
+    int highwater = 0;
+    if (sqlite3_db_status(db_, op, &current, &highwater, reset ? 1 : 0) !=
+        SQLITE_OK) {
+      throw Exception{"status error"};
+    }
+    return current;
+  };
+
+  return {.cache_used = get(SQLITE_DBSTATUS_CACHE_USED),
+          .cache_hits = get(SQLITE_DBSTATUS_CACHE_HIT),
+          .cache_misses = get(SQLITE_DBSTATUS_CACHE_MISS),
+          .cache_writes = get(SQLITE_DBSTATUS_CACHE_WRITE),
+          .cache_spills = get(SQLITE_DBSTATUS_CACHE_SPILL),
+          .schema_used = get(SQLITE_DBSTATUS_SCHEMA_USED),
+          .statement_used = get(SQLITE_DBSTATUS_STMT_USED),
+          .lookaside_used = get(SQLITE_DBSTATUS_LOOKASIDE_USED)};
+}
+
+query_plan connection::explain(std::string_view sql) const {
+  bool explaining = std::exchange(explaining_, true);
+  try {
+    auto plan = ExplainQueryPlan(sql);
+    explaining_ = explaining;
+    return plan;
+  } catch (...) {
+    explaining_ = explaining;
+    throw;
+  }
+}
+
+query_plan connection::ExplainQueryPlan(std::string_view sql) const {
+  std::vector<PlanRow> rows;
+
+  {
+    statement statement{*const_cast<connection*>(this),
+                        std::format("EXPLAIN QUERY PLAN {}", sql)};
+    while (statement.next()) {
+      rows.emplace_back(PlanRow{.id = statement.at(0).as_int(),
+                                .parent = statement.at(1).as_int(),
+                                .detail = statement.at(3).as_string()});
+    }
+  }
+
+  query_plan plan{.nodes = BuildPlanNodes(rows, 0)};
+  ParsePlanTables(plan.nodes);
+
+  auto set_table_rows = [this](auto& self,
+                               std::vector<query_plan_node>& nodes) -> void {
+    for (auto& node : nodes) {
+      if (node.full_scan)
+        node.table_rows = GetTableRowCount(node.table);
+      self(self, node.children);
+    }
+  };
+  set_table_rows(set_table_rows, plan.nodes);
+
+  return plan;
+}
+
+void connection::CheckFullScans(std::string_view sql) const {
+  assert(full_scan_handler_);
+
+  if (explaining_)
+    return;
+
+  auto plan = explain(sql);
+  for (auto* scan : plan.full_scans(full_scan_row_threshold_))
+    full_scan_handler_(sql, *scan);
+}
+
+double connection::GetTableRowCount(std::string_view table_name) const {
+  // The counts expire once the database changes, by this or other
+  // connections.
+  unsigned data_version = 0;
+  sqlite3_file_control(db_, "main", SQLITE_FCNTL_DATA_VERSION, &data_version);
+  auto change_count = sqlite3_total_changes64(db_);
+  if (data_version != table_row_counts_data_version_ ||
+      change_count != table_row_counts_change_count_) {
+    table_row_counts_.clear();
+    table_row_counts_data_version_ = data_version;
+    table_row_counts_change_count_ = change_count;
+  }
+
+  if (auto i = table_row_counts_.find(table_name);
+      i != table_row_counts_.end()) {
+    return i->second;
+  }
+
+  if (!table_exists(table_name))
+    return -1;
+
+  double count = CountTableRows(table_name);
+  table_row_counts_.emplace(std::string{table_name}, count);
+  return count;
+}
+
+double connection::CountTableRows(std::string_view table_name) const {
+  // Prefer the statistics collected by `ANALYZE`. The first number of each
+  // row is the table row count.
+  if (table_exists("sqlite_stat1")) {
+    statement statement{*const_cast<connection*>(this),
+                        "SELECT stat FROM sqlite_stat1 WHERE tbl=? LIMIT 1"};
+    statement.bind(0, table_name);
+    if (statement.next()) {
+      auto stat = statement.at(0).as_string_view();
+      int64_t count = 0;
+      if (std::from_chars(stat.data(), stat.data() + stat.size(), count).ec ==
+          std::errc{}) {
+        return static_cast<double>(count);
+      }
+    }
+  }
+
+  statement statement{*const_cast<connection*>(this),
+                      std::format("SELECT COUNT(*) FROM \"{}\"", table_name)};
+  return statement.next() ? static_cast<double>(statement.at(0).as_int64())
+                          : -1;
+}
+
 }  // namespace sql::sqlite3
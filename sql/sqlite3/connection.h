@@ -1,7 +1,13 @@
 #pragma once
 
+#include "sql/fetch_many.h"
+#include "sql/query_range.h"
+#include "sql/sqlite3/function.h"
+#include "sql/sqlite3/status.h"
 #include "sql/types.h"
 
+#include <functional>
+#include <map>
 #include <memory>
 #include <string>
 #include <vector>
@@ -20,7 +26,7 @@ class connection {
  public:
   using statement = sql::sqlite3::statement;
 
-  connection() = default;
+  connection();
   explicit connection(const open_params& params);
   ~connection();
 
@@ -30,12 +36,41 @@ class connection {
   void open(const open_params& params);
   void close();
 
+  // The underlying SQLite handle, for the extensions built on the C API. Null
+  // while the connection is closed.
+  ::sqlite3* native_handle() const { return db_; }
+
   void query(std::string_view sql);
 
+  // Runs |sql| with |args| bound to its parameters and returns an input range
+  // of |Row|s. See `query_range`.
+  template <class Row, class... Args>
+  query_range<Row, statement> query(std::string_view sql,
+                                    const Args&... args) {
+    return {*this, sql, args...};
+  }
+
+  // Looks up the rows of |keys| with one set-based query per chunk of keys and
+  // returns them by key. |sql| selects the key as the first member of |Row|
+  // and filters it with `IN (?)`, its only parameter. See `fetch_many`.
+  template <class Row, std::ranges::input_range Keys>
+  auto fetch_many(std::string_view sql, Keys&& keys) {
+    return sql::internal::fetch_many<Row>(*this, sql, keys);
+  }
+
+  // Rewrites the `IN (?)` key set placeholder of |sql| for |key_count| keys
+  // bound with `statement::bind_key_set`.
+  std::string key_set_sql(std::string_view sql, size_t key_count) const;
+
   void start();
+  void start(const transaction_options& options);
   void commit();
   void rollback();
 
+  void savepoint(std::string_view name);
+  void release_savepoint(std::string_view name);
+  void rollback_to_savepoint(std::string_view name);
+
   int last_change_count() const;
 
   bool table_exists(std::string_view table_name) const;
@@ -46,10 +81,61 @@ class connection {
 
   std::vector<field_info> table_fields(std::string_view table_name) const;
 
+  // Resets the cache counters after reading them if |reset| is set.
+  connection_status status(bool reset = false) const;
+
+  // Runs `EXPLAIN QUERY PLAN` for |sql|.
+  query_plan explain(std::string_view sql) const;
+
+  // Registers |function| as a scalar SQL function. Argument and result types
+  // are deduced from its signature. Use `std::optional` to accept or return
+  // NULL.
+  template <class F>
+  void create_function(std::string_view name,
+                       F function,
+                       bool deterministic = true);
+
+  // Registers |Aggregate| as an aggregate SQL function. An instance is
+  // default-constructed per group, fed through `step(Args...)`, and its
+  // `value() const` is the result.
+  template <class Aggregate>
+  void create_aggregate(std::string_view name, bool deterministic = true);
+
+  // Same as `create_aggregate`, but the function can also be used as a window
+  // function. |Aggregate| must provide `inverse(Args...)` that removes a row
+  // from the window.
+  template <class Aggregate>
+  void create_window_function(std::string_view name,
+                              bool deterministic = true);
+
  private:
+  static int BusyHandler(void* data, int count);
+
+  // Applies the performance profile and the PRAGMA tuning fields.
+  void ApplyTuning(open_params params);
+
+  query_plan ExplainQueryPlan(std::string_view sql) const;
+  void CheckFullScans(std::string_view sql) const;
+  // Cached per table, as counting the rows is a full scan itself.
+  double GetTableRowCount(std::string_view table_name) const;
+  double CountTableRows(std::string_view table_name) const;
+
   ::sqlite3* db_ = nullptr;
 
-  mutable std::unique_ptr<statement> begin_transaction_statement_;
+  int busy_timeout_ = -1;
+  int busy_waited_ = 0;
+
+  std::function<void(std::string_view sql, const query_plan_node& scan)>
+      full_scan_handler_;
+  double full_scan_row_threshold_ = 0;
+  // Prevents checking the statements prepared by `explain` itself.
+  mutable bool explaining_ = false;
+  mutable std::map<std::string, double, std::less<>> table_row_counts_;
+  mutable unsigned table_row_counts_data_version_ = 0;
+  mutable int64_t table_row_counts_change_count_ = 0;
+
+  // Indexed by `transaction_mode`.
+  mutable std::unique_ptr<statement> begin_transaction_statements_[3];
   mutable std::unique_ptr<statement> commit_transaction_statement_;
   mutable std::unique_ptr<statement> rollback_transaction_statement_;
 
@@ -63,4 +149,35 @@ class connection {
   friend class sql::sqlite3::statement;
 };
 
+template <class F>
+inline void connection::create_function(std::string_view name,
+                                        F function,
+                                        bool deterministic) {
+  using args_type = typename internal::callable_traits<F>::args_type;
+  internal::register_function(
+      db_, name, static_cast<int>(std::tuple_size_v<args_type>), deterministic,
+      internal::function_kind::SCALAR,
+      std::make_unique<internal::scalar_function<F>>(std::move(function)));
+}
+
+template <class Aggregate>
+inline void connection::create_aggregate(std::string_view name,
+                                         bool deterministic) {
+  using function_type = internal::aggregate_function<Aggregate>;
+  internal::register_function(db_, name, function_type::arg_count(),
+                              deterministic, internal::function_kind::AGGREGATE,
+                              std::make_unique<function_type>());
+}
+
+template <class Aggregate>
+inline void connection::create_window_function(std::string_view name,
+                                               bool deterministic) {
+  using function_type = internal::aggregate_function<Aggregate>;
+  static_assert(requires { &Aggregate::inverse; },
+                "Window functions require `inverse`");
+  internal::register_function(db_, name, function_type::arg_count(),
+                              deterministic, internal::function_kind::WINDOW,
+                              std::make_unique<function_type>());
+}
+
 }  // namespace sql::sqlite3
@@ -0,0 +1,229 @@
+#include "sql/sqlite3/connection.h"
+
+#include "sql/exception.h"
+#include "sql/sqlite3/statement.h"
+#include "sql/test/temp_dir.h"
+#include "sql/transaction.h"
+
+#include <chrono>
+#include <gmock/gmock.h>
+#include <thread>
+
+using namespace testing;
+
+namespace sql::sqlite3 {
+
+TEST(SqliteConnectionTest, BusyTimeout) {
+  ScopedTempDir temp_dir;
+  const open_params params{.path = temp_dir.get() / "database.sqlite3",
+                           .busy_timeout = 1000};
+
+  connection writer{params};
+  connection other_writer{params};
+
+  writer.start({.mode = transaction_mode::IMMEDIATE});
+
+  // Releases the write lock well within the busy timeout.
+  std::thread thread{[&writer] {
+    std::this_thread::sleep_for(std::chrono::milliseconds{50});
+    writer.commit();
+  }};
+
+  EXPECT_NO_THROW(other_writer.start({.mode = transaction_mode::IMMEDIATE}));
+  other_writer.commit();
+
+  thread.join();
+}
+
+TEST(SqliteConnectionTest, BusyTimeoutExpires) {
+  ScopedTempDir temp_dir;
+  const open_params params{.path = temp_dir.get() / "database.sqlite3",
+                           .busy_timeout = 20};
+
+  connection writer{params};
+  connection other_writer{params};
+
+  writer.start({.mode = transaction_mode::IMMEDIATE});
+  EXPECT_THROW(other_writer.start({.mode = transaction_mode::IMMEDIATE}),
+               Exception);
+  writer.commit();
+}
+
+TEST(SqliteConnectionTest, FailedCommitRollsBack) {
+  ScopedTempDir temp_dir;
+  connection connection{{.path = temp_dir.get() / "database.sqlite3"}};
+  connection.query("PRAGMA foreign_keys = ON");
+  connection.query("CREATE TABLE p(id INTEGER PRIMARY KEY)");
+  connection.query(
+      "CREATE TABLE c(p_id INTEGER REFERENCES p(id) "
+      "DEFERRABLE INITIALLY DEFERRED)");
+
+  {
+    basic_transaction<sql::sqlite3::connection> transaction{connection};
+    connection.query("INSERT INTO c VALUES(1)");
+    // The deferred foreign key fails the commit and keeps the transaction.
+    EXPECT_THROW(transaction.commit(), Exception);
+  }
+
+  // The failed transaction was rolled back, so a new one can start.
+  EXPECT_NO_THROW(connection.start());
+  connection.commit();
+
+  statement statement{connection, "SELECT COUNT(*) FROM c"};
+  ASSERT_TRUE(statement.next());
+  EXPECT_EQ(0, statement.at(0).as_int64());
+}
+
+TEST(SqliteConnectionTest, Status) {
+  ScopedTempDir temp_dir;
+  connection connection{{.path = temp_dir.get() / "database.sqlite3"}};
+  connection.query("CREATE TABLE t(x INTEGER, y INTEGER)");
+  connection.query("INSERT INTO t VALUES(1, 2), (3, 4), (5, 6)");
+
+  statement statement{connection, "SELECT * FROM t WHERE y = 4 ORDER BY x"};
+  while (statement.next()) {
+  }
+
+  auto status = statement.status(/*reset=*/true);
+  EXPECT_EQ(2, status.fullscan_steps);
+  EXPECT_EQ(1, status.sorts);
+  EXPECT_EQ(1, status.runs);
+  EXPECT_GT(status.vm_steps, 0);
+  EXPECT_GT(status.memory_used, 0);
+
+  // Counters were reset on read.
+  EXPECT_EQ(0, statement.status().fullscan_steps);
+
+  auto connection_status = connection.status();
+  EXPECT_GT(connection_status.cache_used, 0);
+  EXPECT_GT(connection_status.schema_used, 0);
+  EXPECT_GT(connection_status.statement_used, 0);
+}
+
+TEST(SqliteConnectionTest, FullScanHandler) {
+  std::vector<std::string> scans;
+
+  ScopedTempDir temp_dir;
+  connection connection{
+      {.path = temp_dir.get() / "database.sqlite3",
+       .full_scan_handler =
+           [&scans](std::string_view /*sql*/, const query_plan_node& scan) {
+             scans.emplace_back(scan.table);
+           },
+       .full_scan_row_threshold = 2}};
+
+  connection.query("CREATE TABLE small(x INTEGER)");
+  connection.query("CREATE TABLE large(x INTEGER, y INTEGER)");
+  connection.query("CREATE INDEX large_x ON large(x)");
+  connection.query("INSERT INTO small VALUES(1)");
+  connection.query("INSERT INTO large VALUES(1, 1), (2, 2), (3, 3)");
+
+  statement{connection, "SELECT * FROM small"};
+  statement{connection, "SELECT * FROM large WHERE x = 1"};
+  EXPECT_THAT(scans, IsEmpty());
+
+  statement{connection, "SELECT * FROM large WHERE y = 1"};
+  EXPECT_THAT(scans, ElementsAre("large"));
+
+  // The row count seen while the table was small expires.
+  connection.query("INSERT INTO small VALUES(2), (3)");
+  statement{connection, "SELECT * FROM small"};
+  EXPECT_THAT(scans, ElementsAre("large", "small"));
+}
+
+TEST(SqliteConnectionTest, PerformanceProfile) {
+  ScopedTempDir temp_dir;
+  connection connection{{.path = temp_dir.get() / "database.sqlite3",
+                         .profile = performance_profile::DURABLE_OLTP,
+                         .synchronous = synchronous_mode::NORMAL,
+                         .temp_store = temp_store_mode::MEMORY}};
+
+  auto pragma = [&connection](std::string_view name) {
+    statement statement{connection, std::format("PRAGMA {}", name)};
+    EXPECT_TRUE(statement.next());
+    return statement.at(0).as_string();
+  };
+
+  EXPECT_EQ("wal", pragma("journal_mode"));
+  // Explicit fields override the profile.
+  EXPECT_EQ("1", pragma("synchronous"));
+  EXPECT_EQ("-32768", pragma("cache_size"));
+  EXPECT_EQ("2", pragma("temp_store"));
+}
+
+TEST(SqliteConnectionTest, Immutable) {
+  constexpr int kRowCount = 1000;
+  constexpr int kThreadCount = 8;
+
+  ScopedTempDir temp_dir;
+  // Characters with a meaning in URIs.
+  auto path = temp_dir.get() / "reference #1 100%.sqlite3";
+
+  {
+    connection connection{{.path = path}};
+    connection.query("CREATE TABLE t(id INTEGER PRIMARY KEY, v INTEGER)");
+    connection.start();
+    statement insert{connection, "INSERT INTO t(v) VALUES(?)"};
+    for (int i = 0; i < kRowCount; ++i) {
+      insert.bind(0, i);
+      insert.query();
+      insert.reset();
+    }
+    connection.commit();
+  }
+
+  std::vector<std::thread> threads;
+  std::vector<int64_t> sums(kThreadCount);
+  for (int i = 0; i < kThreadCount; ++i) {
+    threads.emplace_back([&path, &sum = sums[i]] {
+      connection connection{
+          {.path = path, .multithreaded = true, .immutable = true}};
+      statement select{connection, "SELECT SUM(v) FROM t"};
+      for (int j = 0; j < 100; ++j) {
+        select.next();
+        sum = select.at(0).as_int64();
+        select.reset();
+      }
+    });
+  }
+  std::ranges::for_each(threads, [](auto& thread) { thread.join(); });
+  EXPECT_THAT(sums, Each(kRowCount * (kRowCount - 1) / 2));
+
+  connection connection{{.path = path, .immutable = true}};
+  statement mmap_size{connection, "PRAGMA mmap_size"};
+  ASSERT_TRUE(mmap_size.next());
+  EXPECT_GT(mmap_size.at(0).as_int64(), 0);
+  EXPECT_THROW(connection.query("INSERT INTO t(v) VALUES(1)"), Exception);
+}
+
+TEST(SqliteConnectionTest, FetchBatchAfterPrepare) {
+  connection connection;
+  connection.open({});
+  connection.query("CREATE TABLE t(v INTEGER)");
+  connection.query("INSERT INTO t VALUES(1), (2)");
+
+  statement select{connection, "SELECT v FROM t"};
+  column_batch batch;
+  EXPECT_EQ(2u, select.fetch_batch(batch, 10));
+  EXPECT_EQ(0u, select.fetch_batch(batch, 10));
+
+  // A statement prepared again starts reading from its first row.
+  select.close();
+  select.prepare(connection, "SELECT v FROM t");
+  EXPECT_EQ(2u, select.fetch_batch(batch, 10));
+}
+
+TEST(SqliteConnectionTest, ColumnNullable) {
+  connection connection;
+  connection.open({});
+  connection.query("CREATE TABLE t(a INTEGER NOT NULL, b TEXT)");
+
+  statement select{connection, "SELECT a, b, a + 1 FROM t"};
+  auto columns = select.columns();
+  ASSERT_EQ(3u, columns.size());
+  EXPECT_EQ(false, columns[0].nullable);
+  EXPECT_EQ(true, columns[1].nullable);
+  EXPECT_EQ(std::nullopt, columns[2].nullable);
+}
+
+}  // namespace sql::sqlite3
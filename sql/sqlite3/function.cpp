@@ -0,0 +1,173 @@
+#include "sql/sqlite3/function.h"
+
+#include "sql/exception.h"
+
+#include <cassert>
+#include <sqlite3.h>
+
+namespace sql::sqlite3 {
+
+namespace {
+
+internal::function_base& GetFunction(::sqlite3_context* context) {
+  return *static_cast<internal::function_base*>(sqlite3_user_data(context));
+}
+
+// Exceptions must not cross the SQLite C boundary.
+template <class Callback>
+void InvokeFunction(::sqlite3_context* context, Callback&& callback) {
+  function_context function_context{context};
+  try {
+    callback(GetFunction(context), function_context);
+  } catch (const std::bad_alloc&) {
+    function_context.error_nomem();
+  } catch (const std::exception& e) {
+    function_context.error(e.what());
+  } catch (...) {
+    function_context.error("Unknown exception in user function");
+  }
+}
+
+void CallFunction(::sqlite3_context* context,
+                  int argc,
+                  ::sqlite3_value** argv) {
+  InvokeFunction(context, [argc, argv](auto& function, auto& context) {
+    function.call(context, argc, argv);
+  });
+}
+
+void StepFunction(::sqlite3_context* context,
+                  int argc,
+                  ::sqlite3_value** argv) {
+  InvokeFunction(context, [argc, argv](auto& function, auto& context) {
+    function.step(context, argc, argv);
+  });
+}
+
+void InverseFunction(::sqlite3_context* context,
+                     int argc,
+                     ::sqlite3_value** argv) {
+  InvokeFunction(context, [argc, argv](auto& function, auto& context) {
+    function.inverse(context, argc, argv);
+  });
+}
+
+void ValueFunction(::sqlite3_context* context) {
+  InvokeFunction(context,
+                 [](auto& function, auto& context) { function.value(context); });
+}
+
+void FinalFunction(::sqlite3_context* context) {
+  InvokeFunction(context,
+                 [](auto& function, auto& context) { function.final(context); });
+}
+
+void DestroyFunction(void* function) {
+  delete static_cast<internal::function_base*>(function);
+}
+
+}  // namespace
+
+// function_arg
+
+field_type function_arg::type() const {
+  return static_cast<field_type>(sqlite3_value_type(value_));
+}
+
+int64_t function_arg::as_int64() const {
+  return sqlite3_value_int64(value_);
+}
+
+double function_arg::as_double() const {
+  return sqlite3_value_double(value_);
+}
+
+std::string_view function_arg::as_string_view() const {
+  const char* text = reinterpret_cast<const char*>(sqlite3_value_text(value_));
+  int length = sqlite3_value_bytes(value_);
+
+  if (text && length > 0)
+    return std::string_view{text, static_cast<size_t>(length)};
+  else
+    return std::string_view{};
+}
+
+// function_context
+
+void function_context::result_null() {
+  sqlite3_result_null(context_);
+}
+
+void function_context::result(int64_t value) {
+  sqlite3_result_int64(context_, value);
+}
+
+void function_context::result(double value) {
+  sqlite3_result_double(context_, value);
+}
+
+void function_context::result(std::string_view value) {
+  sqlite3_result_text(context_, value.data(), static_cast<int>(value.size()),
+                      SQLITE_TRANSIENT);
+}
+
+void function_context::error(const char* message) {
+  sqlite3_result_error(context_, message, -1);
+}
+
+void function_context::error_nomem() {
+  sqlite3_result_error_nomem(context_);
+}
+
+void* function_context::aggregate_state(size_t size) {
+  return sqlite3_aggregate_context(context_, static_cast<int>(size));
+}
+
+namespace internal {
+
+void register_function(::sqlite3* db,
+                       std::string_view name,
+                       int arg_count,
+                       bool deterministic,
+                       function_kind kind,
+                       std::unique_ptr<function_base> function) {
+  assert(db);
+
+  int flags = SQLITE_UTF8;
+  if (deterministic)
+    flags |= SQLITE_DETERMINISTIC;
+
+  std::string name_string{name};
+
+  // SQLite takes ownership of |function| and calls `DestroyFunction` even if
+  // the registration fails.
+  int error = SQLITE_OK;
+  switch (kind) {
+    case function_kind::SCALAR:
+      error = sqlite3_create_function_v2(db, name_string.c_str(), arg_count,
+                                         flags, function.release(),
+                                         &CallFunction, nullptr, nullptr,
+                                         &DestroyFunction);
+      break;
+    case function_kind::AGGREGATE:
+      error = sqlite3_create_function_v2(
+          db, name_string.c_str(), arg_count, flags, function.release(),
+          nullptr, &StepFunction, &FinalFunction, &DestroyFunction);
+      break;
+    case function_kind::WINDOW:
+      error = sqlite3_create_window_function(
+          db, name_string.c_str(), arg_count, flags, function.release(),
+          &StepFunction, &FinalFunction, &ValueFunction, &InverseFunction,
+          &DestroyFunction);
+      break;
+  }
+
+  if (error != SQLITE_OK) {
+    const char* message = sqlite3_errmsg(db);
+    throw Exception{message};
+  }
+}
+
+}  // namespace internal
+
+}  // namespace sql::sqlite3
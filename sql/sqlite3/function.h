@@ -0,0 +1,286 @@
+#pragma once
+
+#include "sql/types.h"
+
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+struct sqlite3;
+struct sqlite3_context;
+struct sqlite3_value;
+
+namespace sql::sqlite3 {
+
+// A read-only view of a single user function argument.
+class function_arg {
+ public:
+  explicit function_arg(::sqlite3_value* value) : value_{value} {}
+
+  field_type type() const;
+  bool is_null() const { return type() == field_type::EMPTY; }
+
+  int64_t as_int64() const;
+  double as_double() const;
+  std::string_view as_string_view() const;
+
+ private:
+  ::sqlite3_value* value_;
+};
+
+// Receives the result of a user function call.
+class function_context {
+ public:
+  explicit function_context(::sqlite3_context* context) : context_{context} {}
+
+  void result_null();
+  void result(int64_t value);
+  void result(double value);
+  void result(std::string_view value);
+  void error(const char* message);
+  void error_nomem();
+
+  // Returns zero-initialized storage that lives for the current aggregate
+  // group. Returns null if |size| is 0 and the storage was never requested.
+  void* aggregate_state(size_t size);
+
+ private:
+  ::sqlite3_context* context_;
+};
+
+namespace internal {
+
+// Type-erased user function. Owned by SQLite once registered.
+class function_base {
+ public:
+  virtual ~function_base() = default;
+
+  virtual void call(function_context&, int, ::sqlite3_value**) {}
+
+  virtual void step(function_context&, int, ::sqlite3_value**) {}
+  virtual void inverse(function_context&, int, ::sqlite3_value**) {}
+  virtual void value(function_context&) {}
+  virtual void final(function_context&) {}
+};
+
+enum class function_kind { SCALAR, AGGREGATE, WINDOW };
+
+// Argument and result marshalling.
+
+template <class T>
+struct function_value;
+
+template <>
+struct function_value<int64_t> {
+  static int64_t get(function_arg arg) { return arg.as_int64(); }
+  static void set(function_context& context, int64_t value) {
+    context.result(value);
+  }
+};
+
+template <>
+struct function_value<int> {
+  static int get(function_arg arg) { return static_cast<int>(arg.as_int64()); }
+  static void set(function_context& context, int value) {
+    context.result(static_cast<int64_t>(value));
+  }
+};
+
+template <>
+struct function_value<bool> {
+  static bool get(function_arg arg) { return arg.as_int64() != 0; }
+  static void set(function_context& context, bool value) {
+    context.result(static_cast<int64_t>(value ? 1 : 0));
+  }
+};
+
+template <>
+struct function_value<double> {
+  static double get(function_arg arg) { return arg.as_double(); }
+  static void set(function_context& context, double value) {
+    context.result(value);
+  }
+};
+
+template <>
+struct function_value<std::string_view> {
+  static std::string_view get(function_arg arg) {
+    return arg.as_string_view();
+  }
+  static void set(function_context& context, std::string_view value) {
+    context.result(value);
+  }
+};
+
+template <>
+struct function_value<std::string> {
+  static std::string get(function_arg arg) {
+    return std::string{arg.as_string_view()};
+  }
+  static void set(function_context& context, const std::string& value) {
+    context.result(std::string_view{value});
+  }
+};
+
+template <class T>
+struct function_value<std::optional<T>> {
+  static std::optional<T> get(function_arg arg) {
+    if (arg.is_null())
+      return std::nullopt;
+    return function_value<T>::get(arg);
+  }
+  static void set(function_context& context, const std::optional<T>& value) {
+    if (value)
+      function_value<T>::set(context, *value);
+    else
+      context.result_null();
+  }
+};
+
+// Deduces the signature of a function pointer, a member function or a
+// callable object.
+
+template <class F>
+struct callable_traits : callable_traits<decltype(&F::operator())> {};
+
+template <class R, class... Args>
+struct callable_traits<R (*)(Args...)> {
+  using result_type = R;
+  using args_type = std::tuple<std::decay_t<Args>...>;
+};
+
+template <class C, class R, class... Args>
+struct callable_traits<R (C::*)(Args...)> : callable_traits<R (*)(Args...)> {};
+
+template <class C, class R, class... Args>
+struct callable_traits<R (C::*)(Args...) const>
+    : callable_traits<R (*)(Args...)> {};
+
+template <class Args, class F, size_t... I>
+decltype(auto) invoke_with_args(F&& f,
+                                ::sqlite3_value** argv,
+                                std::index_sequence<I...>) {
+  return std::forward<F>(f)(
+      function_value<std::tuple_element_t<I, Args>>::get(
+          function_arg{argv[I]})...);
+}
+
+template <class Args, class F>
+decltype(auto) invoke_with_args(F&& f, ::sqlite3_value** argv) {
+  return invoke_with_args<Args>(
+      std::forward<F>(f), argv,
+      std::make_index_sequence<std::tuple_size_v<Args>>{});
+}
+
+template <class F>
+class scalar_function final : public function_base {
+ public:
+  using traits = callable_traits<F>;
+
+  explicit scalar_function(F function) : function_{std::move(function)} {}
+
+  void call(function_context& context,
+            int /*argc*/,
+            ::sqlite3_value** argv) override {
+    using result_type = typename traits::result_type;
+    if constexpr (std::is_void_v<result_type>) {
+      invoke_with_args<typename traits::args_type>(function_, argv);
+      context.result_null();
+    } else {
+      function_value<std::decay_t<result_type>>::set(
+          context,
+          invoke_with_args<typename traits::args_type>(function_, argv));
+    }
+  }
+
+ private:
+  F function_;
+};
+
+// |Aggregate| must be default-constructible and provide `step(Args...)` and
+// `value() const`. Window functions also require `inverse(Args...)`.
+template <class Aggregate>
+class aggregate_function final : public function_base {
+ public:
+  using step_traits = callable_traits<decltype(&Aggregate::step)>;
+  using value_traits = callable_traits<decltype(&Aggregate::value)>;
+
+  void step(function_context& context,
+            int /*argc*/,
+            ::sqlite3_value** argv) override {
+    auto& state = get_state(context);
+    invoke_with_args<typename step_traits::args_type>(
+        [&state](auto&&... args) {
+          state.step(std::forward<decltype(args)>(args)...);
+        },
+        argv);
+  }
+
+  void inverse([[maybe_unused]] function_context& context,
+               int /*argc*/,
+               [[maybe_unused]] ::sqlite3_value** argv) override {
+    if constexpr (requires(Aggregate & a) { &Aggregate::inverse; }) {
+      auto& state = get_state(context);
+      invoke_with_args<typename step_traits::args_type>(
+          [&state](auto&&... args) {
+            state.inverse(std::forward<decltype(args)>(args)...);
+          },
+          argv);
+    }
+  }
+
+  void value(function_context& context) override {
+    auto** slot = static_cast<Aggregate**>(context.aggregate_state(0));
+    if (slot && *slot)
+      set_result(context, **slot);
+    else
+      set_result(context, Aggregate{});
+  }
+
+  void final(function_context& context) override {
+    auto** slot = static_cast<Aggregate**>(context.aggregate_state(0));
+    std::unique_ptr<Aggregate> state{slot ? *slot : nullptr};
+    if (state)
+      set_result(context, *state);
+    else
+      set_result(context, Aggregate{});
+  }
+
+  static constexpr int arg_count() {
+    return static_cast<int>(
+        std::tuple_size_v<typename step_traits::args_type>);
+  }
+
+ private:
+  static Aggregate& get_state(function_context& context) {
+    auto** slot =
+        static_cast<Aggregate**>(context.aggregate_state(sizeof(Aggregate*)));
+    if (!slot)
+      throw std::bad_alloc{};
+    if (!*slot)
+      *slot = new Aggregate{};
+    return **slot;
+  }
+
+  static void set_result(function_context& context, const Aggregate& state) {
+    function_value<std::decay_t<typename value_traits::result_type>>::set(
+        context, state.value());
+  }
+};
+
+void register_function(::sqlite3* db,
+                       std::string_view name,
+                       int arg_count,
+                       bool deterministic,
+                       function_kind kind,
+                       std::unique_ptr<function_base> function);
+
+}  // namespace internal
+
+}  // namespace sql::sqlite3
@@ -0,0 +1,100 @@
+#include "sql/exception.h"
+#include "sql/sqlite3/connection.h"
+#include "sql/sqlite3/statement.h"
+#include "sql/test/temp_dir.h"
+
+#include <gmock/gmock.h>
+#include <optional>
+
+using namespace testing;
+
+namespace sql::sqlite3 {
+
+class FunctionTest : public Test {
+ public:
+  virtual void SetUp() override {
+    connection_.open({.path = temp_dir_.get() / "database.sqlite3"});
+    connection_.query("CREATE TABLE t(x INTEGER)");
+    connection_.query("INSERT INTO t VALUES(1), (2), (3), (NULL)");
+  }
+
+ protected:
+  std::optional<int64_t> QueryInt(std::string_view sql) {
+    statement statement{connection_, sql};
+    EXPECT_TRUE(statement.next());
+    if (statement.type(0) == field_type::EMPTY)
+      return std::nullopt;
+    return statement.at(0).as_int64();
+  }
+
+  ScopedTempDir temp_dir_;
+  connection connection_;
+};
+
+struct Sum {
+  void step(std::optional<int64_t> value) { sum += value.value_or(0); }
+  void inverse(std::optional<int64_t> value) { sum -= value.value_or(0); }
+  int64_t value() const { return sum; }
+
+  int64_t sum = 0;
+};
+
+TEST_F(FunctionTest, ScalarFunction) {
+  connection_.create_function("twice", [](int64_t x) { return x * 2; });
+  connection_.create_function(
+      "concat", [](std::string_view a, const std::string& b) {
+        return std::string{a} + b;
+      });
+  connection_.create_function("null_if_odd", [](std::optional<int64_t> x) {
+    return x && *x % 2 == 0 ? x : std::nullopt;
+  });
+
+  EXPECT_EQ(42, QueryInt("SELECT twice(21)"));
+  EXPECT_EQ(12, QueryInt("SELECT SUM(twice(x)) FROM t"));
+  EXPECT_EQ(std::nullopt, QueryInt("SELECT null_if_odd(3)"));
+  EXPECT_EQ(4, QueryInt("SELECT null_if_odd(4)"));
+
+  statement statement{connection_, "SELECT concat('a', 'b')"};
+  ASSERT_TRUE(statement.next());
+  EXPECT_EQ("ab", statement.at(0).as_string());
+}
+
+TEST_F(FunctionTest, ScalarFunctionError) {
+  connection_.create_function("fail", [](int64_t) -> int64_t {
+    throw std::runtime_error{"failure"};
+  });
+
+  statement statement{connection_, "SELECT fail(1)"};
+  EXPECT_THROW(statement.next(), Exception);
+}
+
+TEST_F(FunctionTest, ScalarFunctionNonStandardException) {
+  connection_.create_function("fail", [](int64_t) -> int64_t { throw 1; });
+
+  statement statement{connection_, "SELECT fail(1)"};
+  EXPECT_THROW(statement.next(), Exception);
+}
+
+TEST_F(FunctionTest, AggregateFunction) {
+  connection_.create_aggregate<Sum>("my_sum");
+
+  EXPECT_EQ(6, QueryInt("SELECT my_sum(x) FROM t"));
+  EXPECT_EQ(0, QueryInt("SELECT my_sum(x) FROM t WHERE x > 10"));
+}
+
+TEST_F(FunctionTest, WindowFunction) {
+  connection_.create_window_function<Sum>("my_sum");
+
+  statement statement{
+      connection_,
+      "SELECT my_sum(x) OVER (ORDER BY x ROWS BETWEEN 1 PRECEDING AND CURRENT "
+      "ROW) FROM t WHERE x IS NOT NULL ORDER BY x"};
+
+  std::vector<int64_t> sums;
+  while (statement.next())
+    sums.push_back(statement.at(0).as_int64());
+
+  EXPECT_THAT(sums, ElementsAre(1, 3, 5));
+}
+
+}  // namespace sql::sqlite3
@@ -0,0 +1,144 @@
+#include "sql/sqlite3/maintenance.h"
+
+#include "sql/exception.h"
+#include "sql/sqlite3/statement.h"
+
+#include <cassert>
+#include <format>
+#include <sqlite3.h>
+
+namespace sql::sqlite3 {
+
+maintenance::maintenance(connection& connection,
+                         const maintenance_options& options)
+    : connection_{connection}, options_{options} {
+  ::sqlite3* db = connection_.native_handle();
+  assert(db);
+
+  const char* path = sqlite3_db_filename(db, "main");
+  if (!path || !*path)
+    throw Exception{"Maintenance requires a database file"};
+
+  {
+    statement statement{connection_, "PRAGMA journal_mode"};
+    if (!statement.next() || statement.at(0).as_string() != "wal")
+      throw Exception{"Maintenance requires a database in WAL mode"};
+  }
+
+  // The journal mode is left as is. Checkpoints are no-ops until the
+  // maintenance connection reads the database and so sees it in WAL mode.
+  maintenance_connection_.open(
+      {.path = path, .busy_timeout = options_.busy_timeout});
+  maintenance_connection_.query("PRAGMA schema_version");
+
+  {
+    statement statement{connection_, "PRAGMA wal_autocheckpoint"};
+    if (statement.next())
+      previous_autocheckpoint_pages_ = statement.at(0).as_int();
+  }
+
+  // Disables the automatic checkpoints, which also use the WAL hook.
+  sqlite3_wal_autocheckpoint(db, 0);
+  sqlite3_wal_hook(db, &maintenance::WalHook, this);
+
+  thread_ = std::thread{[this] { Run(); }};
+}
+
+maintenance::~maintenance() {
+  ::sqlite3* db = connection_.native_handle();
+  sqlite3_wal_hook(db, nullptr, nullptr);
+  sqlite3_wal_autocheckpoint(db, previous_autocheckpoint_pages_);
+
+  {
+    std::lock_guard lock{mutex_};
+    stopping_ = true;
+  }
+  condition_.notify_one();
+  thread_.join();
+}
+
+// static
+int maintenance::WalHook(void* data,
+                         ::sqlite3* /*db*/,
+                         const char* /*name*/,
+                         int pages) {
+  auto& self = *static_cast<maintenance*>(data);
+
+  self.wal_pages_ = pages;
+  self.last_commit_time_ = clock::now().time_since_epoch().count();
+
+  if (pages >= self.options_.passive_checkpoint_pages) {
+    {
+      std::lock_guard lock{self.mutex_};
+      self.checkpoint_requested_ = true;
+    }
+    self.condition_.notify_one();
+  }
+
+  return SQLITE_OK;
+}
+
+void maintenance::Run() {
+  std::unique_lock lock{mutex_};
+
+  while (!stopping_) {
+    condition_.wait_for(lock, options_.idle_time, [this] {
+      return stopping_ || checkpoint_requested_;
+    });
+    if (stopping_)
+      break;
+
+    bool checkpoint_requested = std::exchange(checkpoint_requested_, false);
+    lock.unlock();
+
+    try {
+      if (checkpoint_requested) {
+        Checkpoint(wal_pages_ >= options_.restart_checkpoint_pages
+                       ? SQLITE_CHECKPOINT_RESTART
+                       : SQLITE_CHECKPOINT_PASSIVE);
+      }
+
+      // Runs once per quiet period.
+      auto last_commit_time = last_commit_time_.load();
+      auto idle_since = clock::time_point{clock::duration{last_commit_time}};
+      if (last_commit_time != last_quiet_period_time_ &&
+          clock::now() - idle_since >= options_.idle_time) {
+        last_quiet_period_time_ = last_commit_time;
+        RunQuietPeriodTasks();
+      }
+    } catch (...) {
+      // The database is busy, or the task failed otherwise. Retry on the
+      // next wake-up rather than terminate the process.
+    }
+
+    lock.lock();
+  }
+}
+
+void maintenance::Checkpoint(int mode) {
+  int wal_pages = 0;
+  int checkpointed_pages = 0;
+  ::sqlite3* db = maintenance_connection_.native_handle();
+  int result = sqlite3_wal_checkpoint_v2(db, nullptr, mode, &wal_pages,
+                                         &checkpointed_pages);
+  if (result != SQLITE_OK) {
+    const char* message = sqlite3_errmsg(db);
+    throw Exception{message};
+  }
+
+  ++checkpoint_count_;
+}
+
+void maintenance::RunQuietPeriodTasks() {
+  Checkpoint(SQLITE_CHECKPOINT_TRUNCATE);
+
+  if (options_.optimize)
+    maintenance_connection_.query("PRAGMA optimize");
+
+  if (options_.incremental_vacuum_pages > 0) {
+    maintenance_connection_.query(std::format(
+        "PRAGMA incremental_vacuum({})", options_.incremental_vacuum_pages));
+  }
+}
+
+}  // namespace sql::sqlite3
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "sql/sqlite3/connection.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+struct sqlite3;
+
+namespace sql::sqlite3 {
+
+struct maintenance_options {
+  // WAL size in pages that triggers a PASSIVE checkpoint. It never waits for
+  // readers or writers.
+  int passive_checkpoint_pages = 1000;
+  // WAL size in pages that triggers a RESTART checkpoint. It waits for
+  // readers, so that the next writer restarts the WAL from the beginning.
+  int restart_checkpoint_pages = 16 * 1000;
+
+  // Time without commits after which the WAL is truncated and the quiet
+  // period tasks run.
+  std::chrono::milliseconds idle_time{5000};
+  bool optimize = true;
+  // Free pages to reclaim per quiet period. Requires `auto_vacuum=INCREMENTAL`.
+  int incremental_vacuum_pages = 0;
+
+  // For the maintenance connection.
+  int busy_timeout = 5000;
+};
+
+// Takes over WAL checkpointing of a connection. Automatic checkpoints are
+// turned off, so commits never pay for a checkpoint. Checkpoints run on a
+// background thread with a separate connection to the same database, based
+// on the WAL size reported by `sqlite3_wal_hook` and on idle time.
+class maintenance {
+ public:
+  // |connection| must be in WAL mode and outlive the maintenance.
+  explicit maintenance(connection& connection,
+                       const maintenance_options& options = {});
+  ~maintenance();
+
+  maintenance(const maintenance&) = delete;
+  maintenance& operator=(const maintenance&) = delete;
+
+  int checkpoint_count() const { return checkpoint_count_; }
+
+ private:
+  using clock = std::chrono::steady_clock;
+
+  static int WalHook(void* data, ::sqlite3* db, const char* name, int pages);
+
+  void Run();
+  void Checkpoint(int mode);
+  void RunQuietPeriodTasks();
+
+  connection& connection_;
+  const maintenance_options options_;
+
+  // Restored on destruction.
+  int previous_autocheckpoint_pages_ = 0;
+
+  // Used only on the background thread.
+  sql::sqlite3::connection maintenance_connection_;
+
+  std::atomic<int> wal_pages_ = 0;
+  std::atomic<clock::rep> last_commit_time_ = 0;
+  clock::rep last_quiet_period_time_ = 0;
+  std::atomic<int> checkpoint_count_ = 0;
+
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  bool checkpoint_requested_ = false;
+  bool stopping_ = false;
+
+  std::thread thread_;
+};
+
+}  // namespace sql::sqlite3
@@ -0,0 +1,62 @@
+#include "sql/sqlite3/maintenance.h"
+
+#include "sql/exception.h"
+#include "sql/sqlite3/statement.h"
+#include "sql/test/temp_dir.h"
+
+#include <gmock/gmock.h>
+
+using namespace testing;
+
+namespace sql::sqlite3 {
+
+TEST(MaintenanceTest, CheckpointsInBackground) {
+  ScopedTempDir temp_dir;
+  const auto path = temp_dir.get() / "database.sqlite3";
+  const auto wal_path = std::filesystem::path{path.string() + "-wal"};
+
+  connection connection{{.path = path, .journal = journal_mode::WAL}};
+  connection.query("CREATE TABLE t(x INTEGER)");
+
+  maintenance maintenance{connection,
+                          {.passive_checkpoint_pages = 2,
+                           .idle_time = std::chrono::milliseconds{50}}};
+
+  statement insert{connection, "INSERT INTO t VALUES(?)"};
+  for (int i = 0; i < 100; ++i) {
+    insert.bind(0, i);
+    insert.query();
+    insert.reset();
+  }
+
+  EXPECT_GT(std::filesystem::file_size(wal_path), 0u);
+
+  // The WAL is truncated once the database becomes idle.
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{10};
+  while (std::filesystem::file_size(wal_path) != 0 &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds{10});
+  }
+
+  EXPECT_EQ(0u, std::filesystem::file_size(wal_path));
+  EXPECT_GT(maintenance.checkpoint_count(), 0);
+}
+
+TEST(MaintenanceTest, KeepsJournalModeAndRestoresAutoCheckpoint) {
+  ScopedTempDir temp_dir;
+  const auto path = temp_dir.get() / "database.sqlite3";
+
+  connection connection{{.path = path}};
+  connection.query("CREATE TABLE t(x INTEGER)");
+  EXPECT_THROW(maintenance{connection}, Exception);
+
+  connection.query("PRAGMA journal_mode=WAL");
+  connection.query("PRAGMA wal_autocheckpoint=123");
+  { maintenance maintenance{connection}; }
+
+  statement statement{connection, "PRAGMA wal_autocheckpoint"};
+  ASSERT_TRUE(statement.next());
+  EXPECT_EQ(123, statement.at(0).as_int());
+}
+
+}  // namespace sql::sqlite3
@@ -0,0 +1,297 @@
+#include "sql/sqlite3/memory.h"
+
+#include "sql/exception.h"
+#include "sql/sqlite3/connection.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <sqlite3.h>
+#include <unordered_set>
+#include <vector>
+
+namespace sql::sqlite3 {
+
+namespace {
+
+// Allocations carry a header with their usable size, which SQLite queries
+// through `xSize`. The header keeps the payload 8-byte aligned.
+constexpr size_t kHeaderSize = 8;
+
+// Block sizes, including the header, are powers of two from 32 to 4096.
+constexpr size_t kMinBlockSize = 32;
+constexpr size_t kClassCount = 8;
+constexpr size_t kMaxBlockSize = kMinBlockSize << (kClassCount - 1);
+constexpr size_t kChunkSize = 256 * 1024;
+
+class PoolAllocator {
+ public:
+  void* Allocate(int size);
+  void Free(void* p);
+  void* Reallocate(void* p, int size);
+  void Shutdown();
+
+  static int GetSize(void* p) {
+    return static_cast<int>(*GetHeader(p));
+  }
+
+  static int Roundup(int size) {
+    auto block_size = std::bit_ceil(size + kHeaderSize);
+    if (block_size <= kMaxBlockSize)
+      return static_cast<int>(std::max(block_size, kMinBlockSize) -
+                              kHeaderSize);
+    return static_cast<int>((size + 7) & ~7);
+  }
+
+ private:
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+
+  static uint64_t* GetHeader(void* p) {
+    return reinterpret_cast<uint64_t*>(static_cast<std::byte*>(p) -
+                                       kHeaderSize);
+  }
+
+  static size_t GetClass(size_t block_size) {
+    return std::countr_zero(block_size) - std::countr_zero(kMinBlockSize);
+  }
+
+  std::byte* AllocateBlock(size_t block_size);
+
+  std::mutex mutex_;
+  std::array<FreeBlock*, kClassCount> free_lists_ = {};
+  std::vector<std::byte*> chunks_;
+  std::byte* chunk_position_ = nullptr;
+  size_t chunk_remaining_ = 0;
+};
+
+void* PoolAllocator::Allocate(int size) {
+  auto usable_size = static_cast<size_t>(Roundup(size));
+  auto block_size = usable_size + kHeaderSize;
+
+  std::byte* block = nullptr;
+  if (block_size <= kMaxBlockSize) {
+    std::lock_guard lock{mutex_};
+    block = AllocateBlock(block_size);
+  } else {
+    block = static_cast<std::byte*>(std::malloc(block_size));
+  }
+
+  if (!block)
+    return nullptr;
+
+  *reinterpret_cast<uint64_t*>(block) = usable_size;
+  return block + kHeaderSize;
+}
+
+std::byte* PoolAllocator::AllocateBlock(size_t block_size) {
+  auto& free_list = free_lists_[GetClass(block_size)];
+  if (free_list) {
+    auto* block = free_list;
+    free_list = block->next;
+    return reinterpret_cast<std::byte*>(block);
+  }
+
+  if (chunk_remaining_ < block_size) {
+    // The tail of the previous chunk is abandoned.
+    auto* chunk = static_cast<std::byte*>(std::malloc(kChunkSize));
+    if (!chunk)
+      return nullptr;
+    chunks_.emplace_back(chunk);
+    chunk_position_ = chunk;
+    chunk_remaining_ = kChunkSize;
+  }
+
+  auto* block = chunk_position_;
+  chunk_position_ += block_size;
+  chunk_remaining_ -= block_size;
+  return block;
+}
+
+void PoolAllocator::Free(void* p) {
+  auto block_size = *GetHeader(p) + kHeaderSize;
+  auto* block = reinterpret_cast<std::byte*>(GetHeader(p));
+
+  if (block_size > kMaxBlockSize) {
+    std::free(block);
+    return;
+  }
+
+  std::lock_guard lock{mutex_};
+  auto* free_block = reinterpret_cast<FreeBlock*>(block);
+  auto& free_list = free_lists_[GetClass(block_size)];
+  free_block->next = free_list;
+  free_list = free_block;
+}
+
+void* PoolAllocator::Reallocate(void* p, int size) {
+  auto old_size = GetSize(p);
+  if (Roundup(size) == old_size)
+    return p;
+
+  auto* result = Allocate(size);
+  if (!result)
+    return nullptr;
+
+  std::memcpy(result, p, std::min(old_size, size));
+  Free(p);
+  return result;
+}
+
+void PoolAllocator::Shutdown() {
+  std::lock_guard lock{mutex_};
+  for (auto* chunk : chunks_)
+    std::free(chunk);
+  chunks_.clear();
+  free_lists_.fill(nullptr);
+  chunk_position_ = nullptr;
+  chunk_remaining_ = 0;
+}
+
+PoolAllocator pool_allocator;
+
+const sqlite3_mem_methods kPoolMethods = {
+    .xMalloc = [](int size) { return pool_allocator.Allocate(size); },
+    .xFree = [](void* p) { pool_allocator.Free(p); },
+    .xRealloc = [](void* p,
+                   int size) { return pool_allocator.Reallocate(p, size); },
+    .xSize = &PoolAllocator::GetSize,
+    .xRoundup = &PoolAllocator::Roundup,
+    .xInit = [](void*) { return SQLITE_OK; },
+    .xShutdown = [](void*) { pool_allocator.Shutdown(); },
+    .pAppData = nullptr};
+
+// The open connections, released by `release_memory`.
+struct Registry {
+  std::mutex mutex;
+  std::unordered_set<::sqlite3*> connections;
+};
+
+Registry& GetRegistry() {
+  static Registry registry;
+  return registry;
+}
+
+void CheckConfigResult(int result) {
+  if (result != SQLITE_OK)
+    throw Exception{sqlite3_errstr(result)};
+}
+
+}  // namespace
+
+void configure_memory(const memory_options& options) {
+  // Shutting down SQLite with open connections, of this library or not, is
+  // undefined behavior.
+  if (sqlite3_memory_used() != 0)
+    throw Exception{"Cannot configure memory while SQLite holds memory"};
+
+  // SQLite only accepts the configuration while uninitialized.
+  sqlite3_shutdown();
+
+  // The allocator in use when first configured, which is normally the
+  // system malloc. SQLite only fills it in on initialization.
+  static sqlite3_mem_methods default_methods = [] {
+    sqlite3_mem_methods methods = {};
+    CheckConfigResult(sqlite3_initialize());
+    sqlite3_shutdown();
+    CheckConfigResult(sqlite3_config(SQLITE_CONFIG_GETMALLOC, &methods));
+    return methods;
+  }();
+  static std::unique_ptr<std::byte[]> page_cache;
+
+  CheckConfigResult(sqlite3_config(
+      SQLITE_CONFIG_MALLOC,
+      options.pool_allocator ? &kPoolMethods : &default_methods));
+
+  if (options.page_cache_pages > 0) {
+    int header_size = 0;
+    CheckConfigResult(
+        sqlite3_config(SQLITE_CONFIG_PCACHE_HDRSZ, &header_size));
+    auto slot_size =
+        static_cast<int>(options.page_cache_page_size + header_size);
+    page_cache = std::make_unique<std::byte[]>(
+        static_cast<size_t>(slot_size) * options.page_cache_pages);
+    CheckConfigResult(sqlite3_config(SQLITE_CONFIG_PAGECACHE, page_cache.get(),
+                                     slot_size, options.page_cache_pages));
+  } else {
+    CheckConfigResult(sqlite3_config(SQLITE_CONFIG_PAGECACHE, nullptr, 0, 0));
+    page_cache.reset();
+  }
+
+  CheckConfigResult(sqlite3_initialize());
+
+  set_heap_limits(options.soft_heap_limit, options.hard_heap_limit);
+}
+
+void set_heap_limits(int64_t soft_limit, int64_t hard_limit) {
+  sqlite3_hard_heap_limit64(hard_limit);
+  sqlite3_soft_heap_limit64(soft_limit);
+}
+
+memory_status get_memory_status(bool reset_high_water) {
+  memory_status status;
+  sqlite3_int64 current = 0;
+  sqlite3_int64 high_water = 0;
+
+  sqlite3_status64(SQLITE_STATUS_MEMORY_USED, &current, &high_water,
+                   reset_high_water);
+  status.used = current;
+  status.high_water = high_water;
+
+  sqlite3_status64(SQLITE_STATUS_MALLOC_SIZE, &current, &high_water,
+                   reset_high_water);
+  status.largest_allocation = high_water;
+
+  sqlite3_status64(SQLITE_STATUS_PAGECACHE_USED, &current, &high_water,
+                   reset_high_water);
+  status.page_cache_used = current;
+
+  sqlite3_status64(SQLITE_STATUS_PAGECACHE_OVERFLOW, &current, &high_water,
+                   reset_high_water);
+  status.page_cache_overflow = current;
+
+  return status;
+}
+
+int64_t release_memory(connection& connection) {
+  auto used = sqlite3_memory_used();
+  sqlite3_db_release_memory(connection.native_handle());
+  return std::max<int64_t>(used - sqlite3_memory_used(), 0);
+}
+
+int64_t release_memory() {
+  auto used = sqlite3_memory_used();
+
+  {
+    // Keeps the connections from closing meanwhile.
+    auto& registry = GetRegistry();
+    std::lock_guard lock{registry.mutex};
+    for (auto* db : registry.connections)
+      sqlite3_db_release_memory(db);
+  }
+
+  return std::max<int64_t>(used - sqlite3_memory_used(), 0);
+}
+
+namespace internal {
+
+void register_connection(::sqlite3* db) {
+  auto& registry = GetRegistry();
+  std::lock_guard lock{registry.mutex};
+  registry.connections.emplace(db);
+}
+
+void unregister_connection(::sqlite3* db) {
+  auto& registry = GetRegistry();
+  std::lock_guard lock{registry.mutex};
+  registry.connections.erase(db);
+}
+
+}  // namespace internal
+
+}  // namespace sql::sqlite3
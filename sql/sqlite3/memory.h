@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+struct sqlite3;
+
+namespace sql::sqlite3 {
+
+class connection;
+
+// Process-wide SQLite memory configuration.
+struct memory_options {
+  // Serves small allocations from size-class free lists carved out of large
+  // chunks instead of the system malloc. Chunks are only returned to the
+  // system when SQLite shuts down.
+  bool pool_allocator = false;
+
+  // Preallocates a page cache of |page_cache_pages| pages of up to
+  // |page_cache_page_size| bytes. Pages that do not fit fall back to the heap.
+  size_t page_cache_page_size = 4096;
+  int page_cache_pages = 0;
+
+  // See `set_heap_limits`.
+  int64_t soft_heap_limit = 0;
+  int64_t hard_heap_limit = 0;
+};
+
+// Applies |options| by reinitializing SQLite, which affects every SQLite
+// user in the process. Must be called while SQLite holds no memory, i.e. no
+// connection is open in the process, including those not opened by this
+// library. Throws otherwise. The check relies on the memory statistics, which
+// SQLite can be built or configured without.
+void configure_memory(const memory_options& options);
+
+// Above the soft limit SQLite frees cache pages before allocating more. Above
+// the hard limit allocations fail with SQLITE_NOMEM. Zero disables a limit.
+void set_heap_limits(int64_t soft_limit, int64_t hard_limit);
+
+struct memory_status {
+  // Bytes currently allocated by SQLite and the maximum since the last reset.
+  int64_t used = 0;
+  int64_t high_water = 0;
+  int64_t largest_allocation = 0;
+  // Pages taken from the preallocated page cache and bytes of page cache
+  // allocations that did not fit into it.
+  int64_t page_cache_used = 0;
+  int64_t page_cache_overflow = 0;
+};
+
+memory_status get_memory_status(bool reset_high_water = false);
+
+// Frees as much cache memory as possible from |connection|, e.g. on memory
+// pressure. Returns the number of bytes freed. A connection opened with
+// |open_params::multithreaded| must not be used by other threads meanwhile.
+int64_t release_memory(connection& connection);
+
+// Like the above, for all connections opened by this library.
+int64_t release_memory();
+
+namespace internal {
+
+// Tracks open connections for `release_memory`.
+void register_connection(::sqlite3* db);
+void unregister_connection(::sqlite3* db);
+
+}  // namespace internal
+
+}  // namespace sql::sqlite3
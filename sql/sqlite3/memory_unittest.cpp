@@ -0,0 +1,83 @@
+#include "sql/sqlite3/memory.h"
+
+#include "sql/exception.h"
+#include "sql/sqlite3/connection.h"
+#include "sql/sqlite3/statement.h"
+#include "sql/test/temp_dir.h"
+
+#include <gmock/gmock.h>
+
+using namespace testing;
+
+namespace sql::sqlite3 {
+
+namespace {
+
+void FillTable(connection& connection) {
+  connection.query("CREATE TABLE t(id INTEGER PRIMARY KEY, v TEXT)");
+  connection.start();
+  statement insert{connection, "INSERT INTO t(v) VALUES(?)"};
+  for (int i = 0; i < 1000; ++i) {
+    insert.bind(0, std::string(200, 'x'));
+    insert.query();
+    insert.reset();
+  }
+  connection.commit();
+}
+
+}  // namespace
+
+TEST(MemoryTest, PoolAllocator) {
+  configure_memory({.pool_allocator = true, .page_cache_pages = 64});
+
+  {
+    connection connection;
+    connection.open({});
+
+    // Configuration is rejected while SQLite holds memory.
+    EXPECT_THROW(configure_memory({}), Exception);
+
+    FillTable(connection);
+
+    auto status = get_memory_status();
+    EXPECT_GT(status.used, 0);
+    EXPECT_GE(status.high_water, status.used);
+    EXPECT_GT(status.page_cache_used, 0);
+
+    // An in-memory database cannot drop its pages, so only check that the
+    // call is safe.
+    EXPECT_GE(release_memory(connection), 0);
+    EXPECT_GE(release_memory(), 0);
+
+    statement count{connection, "SELECT COUNT(*) FROM t"};
+    ASSERT_TRUE(count.next());
+    EXPECT_EQ(count.at(0).as_int64(), 1000);
+  }
+
+  configure_memory({});
+}
+
+TEST(MemoryTest, ReleasesAllConnections) {
+  ScopedTempDir temp_dir;
+  connection first;
+  first.open({.path = temp_dir.get() / "first.sqlite3"});
+  FillTable(first);
+  connection second;
+  second.open({.path = temp_dir.get() / "second.sqlite3"});
+  FillTable(second);
+
+  auto used = get_memory_status().used;
+  EXPECT_GT(release_memory(), 0);
+  EXPECT_LT(get_memory_status().used, used);
+}
+
+TEST(MemoryTest, HardHeapLimit) {
+  connection connection;
+  connection.open({});
+
+  set_heap_limits(0, get_memory_status().used + 64 * 1024);
+  EXPECT_THROW(FillTable(connection), Exception);
+  set_heap_limits(0, 0);
+}
+
+}  // namespace sql::sqlite3
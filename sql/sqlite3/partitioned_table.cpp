@@ -0,0 +1,246 @@
+#include "sql/sqlite3/partitioned_table.h"
+
+#include "sql/exception.h"
+#include "sql/sqlite3/connection.h"
+#include "sql/sqlite3/statement.h"
+
+#include <cassert>
+#include <charconv>
+#include <format>
+#include <sqlite3.h>
+
+namespace sql::sqlite3 {
+
+namespace {
+
+const char kPartitionExtension[] = ".sqlite3";
+
+void RemoveDatabaseFiles(const std::filesystem::path& path) {
+  for (auto* suffix : {"", "-wal", "-shm", "-journal"}) {
+    std::error_code ec;
+    std::filesystem::remove(path.string() + suffix, ec);
+  }
+}
+
+}  // namespace
+
+partitioned_table::partitioned_table(connection& connection,
+                                     partitioned_table_options options)
+    : connection_{connection}, options_{std::move(options)} {
+  assert(connection_.native_handle());
+  assert(options_.partition_width > 0);
+
+  max_attached_ = static_cast<size_t>(
+      sqlite3_limit(connection_.native_handle(), SQLITE_LIMIT_ATTACHED, -1));
+  if (max_attached_ == 0)
+    throw Exception{"Attached databases are disabled"};
+
+  empty_table_ = std::format("temp.\"{}_empty\"", options_.table_name);
+  connection_.query(std::format("CREATE TEMP TABLE IF NOT EXISTS {}({})",
+                                empty_table_, options_.table_schema));
+
+  std::filesystem::create_directories(options_.directory);
+
+  // Partition files are named `<table>_<index>.sqlite3`.
+  const auto prefix = options_.table_name + "_";
+  for (const auto& entry :
+       std::filesystem::directory_iterator{options_.directory}) {
+    if (entry.path().extension() != kPartitionExtension)
+      continue;
+
+    auto stem = entry.path().stem().string();
+    if (!stem.starts_with(prefix))
+      continue;
+
+    int64_t index = 0;
+    auto* begin = stem.data() + prefix.size();
+    auto* end = stem.data() + stem.size();
+    auto [ptr, ec] = std::from_chars(begin, end, index);
+    if (ec == std::errc{} && ptr == end)
+      partitions_.emplace(index, partition{.path = entry.path()});
+  }
+}
+
+partitioned_table::~partitioned_table() {
+  for (auto& [index, partition] : partitions_) {
+    if (partition.attached) {
+      try {
+        Detach(index, partition);
+      } catch (const Exception&) {
+      }
+    }
+  }
+
+  try {
+    connection_.query(std::format("DROP TABLE IF EXISTS {}", empty_table_));
+  } catch (const Exception&) {
+  }
+}
+
+void partitioned_table::maintain(int64_t now) {
+  auto current = GetPartitionIndex(now);
+
+  for (auto index = current; index <= current + options_.precreate_count;
+       ++index) {
+    if (!partitions_.contains(index))
+      CreatePartition(index);
+  }
+
+  drop_before((current - options_.retention_count + 1) *
+              options_.partition_width);
+}
+
+std::string partitioned_table::partition_table(int64_t time) {
+  auto index = GetPartitionIndex(time);
+
+  auto i = partitions_.find(index);
+  auto& partition =
+      i != partitions_.end() ? i->second : CreatePartition(index);
+  Attach(index, partition);
+
+  return std::format("{}.{}", GetSchemaName(index), options_.table_name);
+}
+
+std::string partitioned_table::range_query(std::string_view columns,
+                                           int64_t begin,
+                                           int64_t end,
+                                           std::string_view where) {
+  auto first = partitions_.lower_bound(GetPartitionIndex(begin));
+  auto last = partitions_.upper_bound(GetPartitionIndex(end - 1));
+
+  if (first == last)
+    return std::format("SELECT {} FROM {} WHERE 0", columns, empty_table_);
+
+  if (static_cast<size_t>(std::distance(first, last)) > GetAttachCapacity())
+    throw Exception{"Too many partitions in the time range"};
+
+  std::string sql;
+
+  for (auto i = first; i != last; ++i) {
+    auto& [index, partition] = *i;
+    Attach(index, partition);
+
+    if (!sql.empty())
+      sql += " UNION ALL ";
+
+    sql += std::format("SELECT {} FROM {}.{}", columns, GetSchemaName(index),
+                       options_.table_name);
+
+    // Partitions fully inside the range need no time condition.
+    std::string condition;
+    if (index * options_.partition_width < begin)
+      condition = std::format("{}>={}", options_.time_column, begin);
+    if ((index + 1) * options_.partition_width > end) {
+      if (!condition.empty())
+        condition += " AND ";
+      condition += std::format("{}<{}", options_.time_column, end);
+    }
+    if (!where.empty()) {
+      if (!condition.empty())
+        condition += " AND ";
+      condition += std::format("({})", where);
+    }
+
+    if (!condition.empty())
+      sql += std::format(" WHERE {}", condition);
+  }
+
+  return sql;
+}
+
+void partitioned_table::drop_before(int64_t time) {
+  for (auto i = partitions_.begin(); i != partitions_.end();) {
+    auto& [index, partition] = *i;
+    if ((index + 1) * options_.partition_width > time)
+      break;
+
+    if (partition.attached)
+      Detach(index, partition);
+    RemoveDatabaseFiles(partition.path);
+    i = partitions_.erase(i);
+  }
+}
+
+int64_t partitioned_table::GetPartitionIndex(int64_t time) const {
+  auto width = options_.partition_width;
+  // Rounds towards negative infinity.
+  return time >= 0 ? time / width : (time - width + 1) / width;
+}
+
+std::string partitioned_table::GetSchemaName(int64_t index) const {
+  return std::format("\"{}_{}\"", options_.table_name, index);
+}
+
+size_t partitioned_table::GetAttachCapacity() {
+  // `main` and `temp` have sequence numbers 0 and 1.
+  size_t attached_count = 0;
+  statement database_list{connection_, "PRAGMA database_list"};
+  while (database_list.next()) {
+    if (database_list.at(0).as_int() >= 2)
+      ++attached_count;
+  }
+
+  assert(attached_count >= attach_order_.size());
+  size_t foreign_count = attached_count - attach_order_.size();
+  return max_attached_ > foreign_count ? max_attached_ - foreign_count : 0;
+}
+
+partitioned_table::partition& partitioned_table::CreatePartition(
+    int64_t index) {
+  auto path = options_.directory /
+              std::format("{}_{}{}", options_.table_name, index,
+                          kPartitionExtension);
+
+  auto& created =
+      partitions_.emplace(index, partition{.path = std::move(path)})
+          .first->second;
+  Attach(index, created);
+
+  auto schema_name = GetSchemaName(index);
+  connection_.query(std::format("CREATE TABLE IF NOT EXISTS {}.{}({})",
+                                schema_name, options_.table_name,
+                                options_.table_schema));
+  connection_.query(std::format(
+      "CREATE INDEX IF NOT EXISTS {}.{}_{} ON {}({})", schema_name,
+      options_.table_name, options_.time_column, options_.table_name,
+      options_.time_column));
+
+  return created;
+}
+
+void partitioned_table::Attach(int64_t index, partition& partition) {
+  if (partition.attached) {
+    // Mark as most recently used.
+    attach_order_.splice(attach_order_.end(), attach_order_,
+                         partition.attach_position);
+    return;
+  }
+
+  auto capacity = GetAttachCapacity();
+  if (capacity == 0)
+    throw Exception{"Too many attached databases"};
+
+  while (attach_order_.size() >= capacity) {
+    auto lru_index = attach_order_.front();
+    Detach(lru_index, partitions_.at(lru_index));
+  }
+
+  statement attach{connection_,
+                   std::format("ATTACH DATABASE ? AS {}", GetSchemaName(index))};
+  attach.bind(0, partition.path.string());
+  attach.query();
+
+  partition.attached = true;
+  partition.attach_position = attach_order_.insert(attach_order_.end(), index);
+}
+
+void partitioned_table::Detach(int64_t index, partition& partition) {
+  assert(partition.attached);
+
+  connection_.query(std::format("DETACH DATABASE {}", GetSchemaName(index)));
+
+  attach_order_.erase(partition.attach_position);
+  partition.attached = false;
+}
+
+}  // namespace sql::sqlite3
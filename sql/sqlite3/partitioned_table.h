@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <map>
+#include <string>
+#include <string_view>
+
+namespace sql::sqlite3 {
+
+class connection;
+
+struct partitioned_table_options {
+  // Directory holding one database file per partition.
+  std::filesystem::path directory;
+  std::string table_name;
+  // Column definitions, e.g. "ts INTEGER NOT NULL, payload TEXT".
+  std::string table_schema;
+  // The partitioning column. It gets an index in every partition.
+  std::string time_column = "ts";
+
+  // Width of a partition in units of |time_column|.
+  int64_t partition_width = 24 * 60 * 60;
+  // Partitions created ahead of the current one by `maintain`.
+  int precreate_count = 1;
+  // Partitions kept by `maintain`, including the current one.
+  int retention_count = 7;
+};
+
+// Stores each time window of an append-mostly table in its own database
+// file, attached to |connection| on demand. Retention drops whole files
+// instead of deleting rows. SQLite limits the number of attached databases
+// (10 by default), so only recently used partitions stay attached. The
+// databases attached by the caller count towards the limit.
+class partitioned_table {
+ public:
+  // Picks up the partition files that already exist in the directory.
+  partitioned_table(connection& connection, partitioned_table_options options);
+  ~partitioned_table();
+
+  partitioned_table(const partitioned_table&) = delete;
+  partitioned_table& operator=(const partitioned_table&) = delete;
+
+  // Creates the partitions ahead of |now| and drops the expired ones.
+  void maintain(int64_t now);
+
+  // Returns the qualified name of the partition holding |time|, e.g. to
+  // insert rows. Creates and attaches the partition if needed. The name is
+  // valid until a later call detaches the partition to attach others.
+  std::string partition_table(int64_t time);
+
+  // Returns a query selecting |columns| from the rows in [begin, end). It is
+  // a UNION ALL over the existing partitions that overlap the range, which
+  // are attached. The optional |where| condition is repeated in every
+  // branch, so use numbered parameters (`?1`) in it. If no partition
+  // overlaps the range, the query selects from an empty temporary table and
+  // no partition is created. Like `partition_table`, the query is valid
+  // until a later call detaches one of its partitions, so prepare it first.
+  std::string range_query(std::string_view columns,
+                          int64_t begin,
+                          int64_t end,
+                          std::string_view where = {});
+
+  // Detaches and deletes the partitions that end at or before |time|.
+  void drop_before(int64_t time);
+
+  size_t partition_count() const { return partitions_.size(); }
+
+ private:
+  struct partition {
+    std::filesystem::path path;
+    bool attached = false;
+    // Position in |attach_order_| if attached.
+    std::list<int64_t>::iterator attach_position;
+  };
+
+  int64_t GetPartitionIndex(int64_t time) const;
+  std::string GetSchemaName(int64_t index) const;
+  // The number of partitions that can be attached at once, given the
+  // databases attached by others.
+  size_t GetAttachCapacity();
+
+  partition& CreatePartition(int64_t index);
+  void Attach(int64_t index, partition& partition);
+  void Detach(int64_t index, partition& partition);
+
+  connection& connection_;
+  const partitioned_table_options options_;
+
+  // Keyed by partition index, which is `time / partition_width`.
+  std::map<int64_t, partition> partitions_;
+
+  // Attached partition indexes, least recently used first.
+  std::list<int64_t> attach_order_;
+  // The SQLite limit of attached databases.
+  size_t max_attached_ = 0;
+
+  // The empty table of `range_query` when no partition overlaps the range.
+  std::string empty_table_;
+};
+
+}  // namespace sql::sqlite3
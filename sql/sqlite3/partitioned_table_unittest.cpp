@@ -0,0 +1,132 @@
+#include "sql/sqlite3/partitioned_table.h"
+
+#include "sql/exception.h"
+#include "sql/sqlite3/connection.h"
+#include "sql/sqlite3/statement.h"
+#include "sql/test/temp_dir.h"
+
+#include <gmock/gmock.h>
+
+using namespace testing;
+
+namespace sql::sqlite3 {
+
+namespace {
+
+constexpr int64_t kWidth = 100;
+
+partitioned_table_options MakeOptions(const std::filesystem::path& directory) {
+  return {.directory = directory,
+          .table_name = "events",
+          .table_schema = "ts INTEGER NOT NULL, v INTEGER",
+          .partition_width = kWidth,
+          .retention_count = 3};
+}
+
+void Insert(connection& connection,
+            partitioned_table& table,
+            int64_t ts,
+            int64_t v) {
+  statement insert{connection, std::format("INSERT INTO {} VALUES(?, ?)",
+                                           table.partition_table(ts))};
+  insert.bind(0, ts);
+  insert.bind(1, v);
+  insert.query();
+}
+
+std::vector<int64_t> QueryValues(connection& connection,
+                                 const std::string& sql) {
+  statement select{connection,
+                   std::format("SELECT v FROM ({}) ORDER BY v", sql)};
+  std::vector<int64_t> values;
+  while (select.next())
+    values.emplace_back(select.at(0).as_int64());
+  return values;
+}
+
+}  // namespace
+
+TEST(PartitionedTableTest, RangeQuery) {
+  ScopedTempDir temp_dir;
+  connection connection;
+  connection.open({});
+  partitioned_table table{connection, MakeOptions(temp_dir.get())};
+
+  for (int64_t ts = 0; ts < 3 * kWidth; ts += 10)
+    Insert(connection, table, ts, ts);
+  EXPECT_EQ(table.partition_count(), 3u);
+
+  EXPECT_THAT(QueryValues(connection, table.range_query("v", 90, 210)),
+              ElementsAre(90, 100, 110, 120, 130, 140, 150, 160, 170, 180,
+                          190, 200));
+  EXPECT_THAT(QueryValues(connection, table.range_query("v", 0, 300, "v<?1")),
+              IsEmpty());
+  EXPECT_THAT(QueryValues(connection, table.range_query("v", 1000, 2000)),
+              IsEmpty());
+  EXPECT_EQ(table.partition_count(), 3u);
+  EXPECT_FALSE(std::filesystem::exists(temp_dir.get() / "events_10.sqlite3"));
+}
+
+TEST(PartitionedTableTest, Retention) {
+  ScopedTempDir temp_dir;
+  connection connection;
+  connection.open({});
+
+  {
+    partitioned_table table{connection, MakeOptions(temp_dir.get())};
+    for (int64_t ts = 0; ts < 5 * kWidth; ts += kWidth)
+      Insert(connection, table, ts, ts);
+
+    // Keeps 3 partitions up to the current one, plus the precreated one.
+    table.maintain(4 * kWidth);
+    EXPECT_EQ(table.partition_count(), 4u);
+    EXPECT_THAT(
+        QueryValues(connection, table.range_query("v", 0, 10 * kWidth)),
+        ElementsAre(200, 300, 400));
+  }
+
+  // Reopening picks up the remaining files.
+  partitioned_table table{connection, MakeOptions(temp_dir.get())};
+  EXPECT_EQ(table.partition_count(), 4u);
+  EXPECT_FALSE(std::filesystem::exists(temp_dir.get() / "events_0.sqlite3"));
+}
+
+TEST(PartitionedTableTest, DetachesLeastRecentlyUsed) {
+  ScopedTempDir temp_dir;
+  connection connection;
+  connection.open({});
+  partitioned_table table{connection, MakeOptions(temp_dir.get())};
+
+  // More partitions than SQLite can attach at once.
+  constexpr int kPartitionCount = 20;
+  for (int64_t i = 0; i < kPartitionCount; ++i)
+    Insert(connection, table, i * kWidth, i);
+
+  EXPECT_THAT(QueryValues(connection, table.range_query("v", 0, 3 * kWidth)),
+              ElementsAre(0, 1, 2));
+  EXPECT_THROW(table.range_query("v", 0, kPartitionCount * kWidth), Exception);
+}
+
+TEST(PartitionedTableTest, CountsDatabasesAttachedByCaller) {
+  ScopedTempDir temp_dir;
+  connection connection;
+  connection.open({});
+
+  // Leaves 2 of the default 10 attached databases to the table.
+  for (int i = 0; i < 8; ++i)
+    connection.query(std::format("ATTACH DATABASE ':memory:' AS other_{}", i));
+
+  partitioned_table table{connection, MakeOptions(temp_dir.get())};
+  for (int64_t i = 0; i < 4; ++i)
+    Insert(connection, table, i * kWidth, i);
+
+  EXPECT_THAT(QueryValues(connection, table.range_query("v", 0, 2 * kWidth)),
+              ElementsAre(0, 1));
+  EXPECT_THROW(table.range_query("v", 0, 3 * kWidth), Exception);
+  Insert(connection, table, 3 * kWidth, 3);
+  EXPECT_THAT(
+      QueryValues(connection, table.range_query("v", 2 * kWidth, 4 * kWidth)),
+      ElementsAre(2, 3, 3));
+}
+
+}  // namespace sql::sqlite3
@@ -0,0 +1,111 @@
+#include "sql/sqlite3/connection.h"
+#include "sql/sqlite3/statement.h"
+#include "sql/sqlite3/test/benchmark_database.h"
+
+#include <benchmark/benchmark.h>
+
+namespace sql::sqlite3 {
+
+namespace {
+
+constexpr std::pair<performance_profile, const char*> kProfiles[] = {
+    {performance_profile::DEFAULT, "default"},
+    {performance_profile::DURABLE_OLTP, "durable_oltp"},
+    {performance_profile::BULK_LOAD, "bulk_load"},
+    {performance_profile::READ_ONLY_ANALYTICS, "read_only_analytics"},
+};
+
+constexpr int kRowCount = 100'000;
+
+// Opens the database with the profile selected by the benchmark argument.
+open_params GetOpenParams(const benchmark::State& state) {
+  return {.profile = kProfiles[state.range(0)].first};
+}
+
+void SetLabel(benchmark::State& state) {
+  state.SetLabel(kProfiles[state.range(0)].second);
+}
+
+// One row per transaction. Measures the commit latency.
+void BM_InsertCommit(benchmark::State& state) {
+  BenchmarkDatabase database{GetOpenParams(state)};
+  statement insert{database.get(), "INSERT INTO t(a, b) VALUES(?, ?)"};
+
+  int i = 0;
+  for (auto _ : state) {
+    insert.bind(0, i++);
+    insert.bind(1, "value");
+    insert.query();
+    insert.reset();
+  }
+
+  state.SetItemsProcessed(state.iterations());
+  SetLabel(state);
+}
+
+// 1000 rows per transaction. Measures the insert throughput.
+void BM_InsertBatch(benchmark::State& state) {
+  constexpr int kBatchSize = 1000;
+
+  BenchmarkDatabase database{GetOpenParams(state)};
+  statement insert{database.get(), "INSERT INTO t(a, b) VALUES(?, ?)"};
+
+  int i = 0;
+  for (auto _ : state) {
+    database.get().start();
+    for (int j = 0; j < kBatchSize; ++j) {
+      insert.bind(0, i++);
+      insert.bind(1, "value");
+      insert.query();
+      insert.reset();
+    }
+    database.get().commit();
+  }
+
+  state.SetItemsProcessed(state.iterations() * kBatchSize);
+  SetLabel(state);
+}
+
+void BM_PointSelect(benchmark::State& state) {
+  BenchmarkDatabase database{GetOpenParams(state)};
+  database.Populate(kRowCount);
+
+  statement select{database.get(), "SELECT a, b FROM t WHERE id=?"};
+
+  int i = 0;
+  for (auto _ : state) {
+    select.bind(0, 1 + (i++ * 7919) % kRowCount);
+    benchmark::DoNotOptimize(select.next());
+    benchmark::DoNotOptimize(select.at(1).as_string_view());
+    select.reset();
+  }
+
+  state.SetItemsProcessed(state.iterations());
+  SetLabel(state);
+}
+
+// A full scan with a sort that spills into temporary storage.
+void BM_SortedScan(benchmark::State& state) {
+  BenchmarkDatabase database{GetOpenParams(state)};
+  database.Populate(kRowCount);
+
+  statement select{database.get(), "SELECT a, b FROM t ORDER BY b"};
+
+  for (auto _ : state) {
+    while (select.next())
+      benchmark::DoNotOptimize(select.at(0).as_int());
+    select.reset();
+  }
+
+  state.SetItemsProcessed(state.iterations() * kRowCount);
+  SetLabel(state);
+}
+
+}  // namespace
+
+BENCHMARK(BM_InsertCommit)->DenseRange(0, std::size(kProfiles) - 1);
+BENCHMARK(BM_InsertBatch)->DenseRange(0, std::size(kProfiles) - 1);
+BENCHMARK(BM_PointSelect)->DenseRange(0, std::size(kProfiles) - 1);
+BENCHMARK(BM_SortedScan)->DenseRange(0, std::size(kProfiles) - 1);
+
+}  // namespace sql::sqlite3
@@ -0,0 +1,171 @@
+#include "sql/sqlite3/session.h"
+
+#include "sql/exception.h"
+#include "sql/sqlite3/connection.h"
+
+#include <cassert>
+#include <exception>
+#include <sqlite3.h>
+
+namespace sql::sqlite3 {
+
+namespace {
+
+void CheckSessionResult(int result) {
+  if (result != SQLITE_OK)
+    throw Exception{sqlite3_errstr(result)};
+}
+
+std::vector<std::byte> TakeBuffer(int size, void* buffer) {
+  auto* data = static_cast<const std::byte*>(buffer);
+  std::vector<std::byte> result{data, data + size};
+  sqlite3_free(buffer);
+  return result;
+}
+
+conflict_type GetConflictType(int type) {
+  switch (type) {
+    case SQLITE_CHANGESET_DATA:
+      return conflict_type::DATA;
+    case SQLITE_CHANGESET_NOTFOUND:
+      return conflict_type::NOT_FOUND;
+    case SQLITE_CHANGESET_CONFLICT:
+      return conflict_type::CONFLICT;
+    case SQLITE_CHANGESET_CONSTRAINT:
+      return conflict_type::CONSTRAINT;
+    default:
+      return conflict_type::FOREIGN_KEY;
+  }
+}
+
+int GetConflictAction(conflict_action action) {
+  switch (action) {
+    case conflict_action::OMIT:
+      return SQLITE_CHANGESET_OMIT;
+    case conflict_action::REPLACE:
+      return SQLITE_CHANGESET_REPLACE;
+    default:
+      return SQLITE_CHANGESET_ABORT;
+  }
+}
+
+struct ApplyContext {
+  const conflict_handler& handler;
+  std::exception_ptr exception;
+};
+
+int ConflictHandler(void* context,
+                    int type,
+                    ::sqlite3_changeset_iter* iter) {
+  auto& apply_context = *static_cast<ApplyContext*>(context);
+  if (!apply_context.handler)
+    return SQLITE_CHANGESET_ABORT;
+
+  try {
+    return GetConflictAction(
+        apply_context.handler(conflict{GetConflictType(type), iter}));
+  } catch (...) {
+    apply_context.exception = std::current_exception();
+    return SQLITE_CHANGESET_ABORT;
+  }
+}
+
+}  // namespace
+
+// session
+
+session::session(connection& connection, std::string_view schema) {
+  assert(connection.native_handle());
+  CheckSessionResult(sqlite3session_create(
+      connection.native_handle(), std::string{schema}.c_str(), &session_));
+}
+
+session::~session() {
+  sqlite3session_delete(session_);
+}
+
+void session::attach(std::string_view table_name) {
+  CheckSessionResult(
+      sqlite3session_attach(session_, std::string{table_name}.c_str()));
+}
+
+void session::attach_all() {
+  CheckSessionResult(sqlite3session_attach(session_, nullptr));
+}
+
+void session::enable(bool enabled) {
+  sqlite3session_enable(session_, enabled ? 1 : 0);
+}
+
+bool session::empty() const {
+  return sqlite3session_isempty(session_) != 0;
+}
+
+std::vector<std::byte> session::changeset() const {
+  int size = 0;
+  void* buffer = nullptr;
+  CheckSessionResult(sqlite3session_changeset(session_, &size, &buffer));
+  return TakeBuffer(size, buffer);
+}
+
+std::vector<std::byte> session::patchset() const {
+  int size = 0;
+  void* buffer = nullptr;
+  CheckSessionResult(sqlite3session_patchset(session_, &size, &buffer));
+  return TakeBuffer(size, buffer);
+}
+
+void session::apply(connection& connection,
+                    std::span<const std::byte> changeset,
+                    const conflict_handler& handler) {
+  assert(connection.native_handle());
+
+  ApplyContext context{handler};
+  int result = sqlite3changeset_apply(
+      connection.native_handle(), static_cast<int>(changeset.size()),
+      const_cast<std::byte*>(changeset.data()), /*xFilter=*/nullptr,
+      &ConflictHandler, &context);
+
+  if (context.exception)
+    std::rethrow_exception(context.exception);
+  CheckSessionResult(result);
+}
+
+// conflict
+
+conflict::conflict(conflict_type type, ::sqlite3_changeset_iter* iter)
+    : type_{type}, iter_{iter} {
+  const char* table_name = nullptr;
+  int operation = 0;
+  int indirect = 0;
+  sqlite3changeset_op(iter_, &table_name, &column_count_, &operation,
+                      &indirect);
+
+  table_name_ = table_name;
+  operation_ = operation == SQLITE_INSERT   ? change_operation::INSERT
+               : operation == SQLITE_UPDATE ? change_operation::UPDATE
+                                            : change_operation::DELETE;
+}
+
+std::optional<function_arg> conflict::old_value(int column) const {
+  ::sqlite3_value* value = nullptr;
+  if (sqlite3changeset_old(iter_, column, &value) != SQLITE_OK || !value)
+    return std::nullopt;
+  return function_arg{value};
+}
+
+std::optional<function_arg> conflict::new_value(int column) const {
+  ::sqlite3_value* value = nullptr;
+  if (sqlite3changeset_new(iter_, column, &value) != SQLITE_OK || !value)
+    return std::nullopt;
+  return function_arg{value};
+}
+
+std::optional<function_arg> conflict::conflicting_value(int column) const {
+  ::sqlite3_value* value = nullptr;
+  if (sqlite3changeset_conflict(iter_, column, &value) != SQLITE_OK || !value)
+    return std::nullopt;
+  return function_arg{value};
+}
+
+}  // namespace sql::sqlite3
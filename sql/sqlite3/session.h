@@ -0,0 +1,110 @@
+#pragma once
+
+#include "sql/sqlite3/change_operation.h"
+#include "sql/sqlite3/function.h"
+
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct sqlite3_changeset_iter;
+struct sqlite3_session;
+
+namespace sql::sqlite3 {
+
+class connection;
+
+enum class conflict_type {
+  // The row to update or delete has values different from the changeset.
+  DATA,
+  // The row to update or delete does not exist.
+  NOT_FOUND,
+  // The inserted primary key exists.
+  CONFLICT,
+  // The change violates a constraint.
+  CONSTRAINT,
+  // Applying the changeset leaves foreign key violations.
+  FOREIGN_KEY,
+};
+
+enum class conflict_action {
+  // Skips the change.
+  OMIT,
+  // Overwrites the existing row. Only valid for |DATA| and |CONFLICT|.
+  REPLACE,
+  // Rolls back the whole changeset.
+  ABORT,
+};
+
+// A change that cannot be applied as is. Values are only valid during the
+// conflict handler call.
+class conflict {
+ public:
+  conflict(conflict_type type, ::sqlite3_changeset_iter* iter);
+
+  conflict_type type() const { return type_; }
+  std::string_view table_name() const { return table_name_; }
+  change_operation operation() const { return operation_; }
+  int column_count() const { return column_count_; }
+
+  // The row before an update or delete. A patchset only has the primary key
+  // of a deleted row.
+  std::optional<function_arg> old_value(int column) const;
+  // The row after an insert or update. Empty for the columns an update leaves
+  // unchanged.
+  std::optional<function_arg> new_value(int column) const;
+  // The existing row of a |DATA| or |CONFLICT| conflict.
+  std::optional<function_arg> conflicting_value(int column) const;
+
+ private:
+  conflict_type type_;
+  ::sqlite3_changeset_iter* iter_;
+  std::string_view table_name_;
+  change_operation operation_ = change_operation::INSERT;
+  int column_count_ = 0;
+};
+
+using conflict_handler = std::function<conflict_action(const conflict&)>;
+
+// Records the changes made to the attached tables of a connection, so that
+// only the differences need to be shipped to a replica. Tables must have a
+// primary key.
+class session {
+ public:
+  explicit session(connection& connection, std::string_view schema = "main");
+  ~session();
+
+  session(const session&) = delete;
+  session& operator=(const session&) = delete;
+
+  void attach(std::string_view table_name);
+  // Includes tables created later.
+  void attach_all();
+
+  // Changes are not recorded while disabled.
+  void enable(bool enabled);
+
+  bool empty() const;
+
+  // Row changes with the old values of updated and deleted rows. A changeset
+  // can be inverted and allows precise conflict detection.
+  std::vector<std::byte> changeset() const;
+  // A more compact format with only the primary keys of deleted rows and the
+  // modified columns of updated rows.
+  std::vector<std::byte> patchset() const;
+
+  // Applies a changeset or a patchset atomically. Without a handler any
+  // conflict aborts. Throws if aborted.
+  static void apply(connection& connection,
+                    std::span<const std::byte> changeset,
+                    const conflict_handler& handler = {});
+
+ private:
+  ::sqlite3_session* session_ = nullptr;
+};
+
+}  // namespace sql::sqlite3
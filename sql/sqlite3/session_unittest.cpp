@@ -0,0 +1,99 @@
+#include "sql/sqlite3/session.h"
+
+#include "sql/exception.h"
+#include "sql/sqlite3/connection.h"
+#include "sql/sqlite3/statement.h"
+
+#include <format>
+#include <gmock/gmock.h>
+
+using namespace testing;
+
+namespace sql::sqlite3 {
+
+namespace {
+
+void CreateTable(connection& connection) {
+  connection.query("CREATE TABLE t(id INTEGER PRIMARY KEY, v TEXT)");
+}
+
+std::vector<std::string> GetRows(connection& connection) {
+  statement select{connection, "SELECT id, v FROM t ORDER BY id"};
+  std::vector<std::string> rows;
+  while (select.next()) {
+    rows.emplace_back(std::format("{}={}", select.at(0).as_int64(),
+                                  select.at(1).as_string()));
+  }
+  return rows;
+}
+
+}  // namespace
+
+class SessionTest : public Test {
+ public:
+  void SetUp() override {
+    source_.open({});
+    replica_.open({});
+    CreateTable(source_);
+    CreateTable(replica_);
+
+    source_.query("INSERT INTO t VALUES(1, 'a'), (2, 'b'), (3, 'c')");
+    replica_.query("INSERT INTO t VALUES(1, 'a'), (2, 'b'), (3, 'c')");
+  }
+
+ protected:
+  connection source_;
+  connection replica_;
+};
+
+TEST_F(SessionTest, ReplicatesChanges) {
+  session session{source_};
+  session.attach("t");
+  EXPECT_TRUE(session.empty());
+
+  source_.query("INSERT INTO t VALUES(4, 'd')");
+  source_.query("UPDATE t SET v = 'B' WHERE id = 2");
+  source_.query("DELETE FROM t WHERE id = 3");
+  EXPECT_FALSE(session.empty());
+
+  auto patchset = session.patchset();
+  auto changeset = session.changeset();
+  EXPECT_LT(patchset.size(), changeset.size());
+
+  session::apply(replica_, changeset);
+  EXPECT_THAT(GetRows(replica_), ElementsAre("1=a", "2=B", "4=d"));
+}
+
+TEST_F(SessionTest, ResolvesConflicts) {
+  session session{source_};
+  session.attach_all();
+  source_.query("UPDATE t SET v = 'A' WHERE id = 1");
+  source_.query("INSERT INTO t VALUES(4, 'd')");
+
+  replica_.query("UPDATE t SET v = 'x' WHERE id = 1");
+  replica_.query("INSERT INTO t VALUES(4, 'y')");
+
+  auto changeset = session.changeset();
+
+  // Aborts by default and leaves the replica intact.
+  EXPECT_THROW(session::apply(replica_, changeset), Exception);
+  EXPECT_THAT(GetRows(replica_), ElementsAre("1=x", "2=b", "3=c", "4=y"));
+
+  std::vector<conflict_type> conflicts;
+  session::apply(replica_, changeset, [&](const conflict& conflict) {
+    conflicts.emplace_back(conflict.type());
+    EXPECT_EQ(conflict.table_name(), "t");
+    EXPECT_EQ(conflict.column_count(), 2);
+    auto value = conflict.conflicting_value(1);
+    EXPECT_TRUE(value.has_value());
+    // Keeps the local update and takes the remote insert.
+    return value && value->as_string_view() == "x" ? conflict_action::OMIT
+                                                   : conflict_action::REPLACE;
+  });
+
+  EXPECT_THAT(conflicts, UnorderedElementsAre(conflict_type::DATA,
+                                              conflict_type::CONFLICT));
+  EXPECT_THAT(GetRows(replica_), ElementsAre("1=x", "2=b", "3=c", "4=d"));
+}
+
+}  // namespace sql::sqlite3
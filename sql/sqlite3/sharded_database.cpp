@@ -0,0 +1,61 @@
+#include "sql/sqlite3/sharded_database.h"
+
+#include <cassert>
+#include <format>
+
+namespace sql::sqlite3 {
+
+namespace {
+
+// FNV-1a. Unlike `std::hash`, it's the same for every build.
+uint64_t HashBytes(std::string_view bytes) {
+  uint64_t hash = 14695981039346656037ull;
+  for (auto c : bytes) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+// SplitMix64 finalizer. Spreads sequential keys evenly.
+uint64_t HashInteger(uint64_t value) {
+  value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+  value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+  return value ^ (value >> 31);
+}
+
+}  // namespace
+
+sharded_database::sharded_database(const std::filesystem::path& directory,
+                                   size_t shard_count,
+                                   const open_params& params) {
+  assert(shard_count > 0);
+
+  std::filesystem::create_directories(directory);
+
+  shards_.reserve(shard_count);
+  for (size_t i = 0; i < shard_count; ++i) {
+    auto shard_params = params;
+    shard_params.path = directory / std::format("shard_{}.sqlite3", i);
+
+    shards_.emplace_back(std::make_unique<shard>())
+        ->connection.open(shard_params);
+  }
+}
+
+sharded_database::~sharded_database() = default;
+
+size_t sharded_database::shard_index(int64_t key) const {
+  return HashInteger(static_cast<uint64_t>(key)) % shards_.size();
+}
+
+size_t sharded_database::shard_index(std::string_view key) const {
+  return HashBytes(key) % shards_.size();
+}
+
+void sharded_database::query_all(std::string_view sql) {
+  for_each_shard(
+      [sql](connection& connection, size_t) { connection.query(sql); });
+}
+
+}  // namespace sql::sqlite3
@@ -0,0 +1,174 @@
+#pragma once
+
+#include "sql/sqlite3/connection.h"
+#include "sql/sqlite3/statement.h"
+#include "sql/types.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+namespace sql::sqlite3 {
+
+// Hash-partitions a keyspace across several database files, one writer
+// connection per file, so that writes to different shards proceed in
+// parallel. The key-to-shard mapping is stable across processes and builds.
+class sharded_database {
+ public:
+  // Opens `shard_<i>.sqlite3` files in |directory|. |params| applies to every
+  // shard; its path is ignored.
+  sharded_database(const std::filesystem::path& directory,
+                   size_t shard_count,
+                   const open_params& params = {});
+  ~sharded_database();
+
+  sharded_database(const sharded_database&) = delete;
+  sharded_database& operator=(const sharded_database&) = delete;
+
+  size_t shard_count() const { return shards_.size(); }
+
+  size_t shard_index(int64_t key) const;
+  size_t shard_index(std::string_view key) const;
+
+  // Runs `f(connection&)` with exclusive access to the shard owning |key|.
+  template <class Key, class F>
+  decltype(auto) with_shard(const Key& key, F&& f);
+
+  // Runs `f(connection&, shard_index)` on every shard in parallel and returns
+  // the results in shard order.
+  template <class F>
+  auto for_each_shard(F&& f);
+
+  // Runs |sql| on every shard, e.g. to create the schema.
+  void query_all(std::string_view sql);
+
+  // Runs |sql| on every shard in parallel and collects the rows read by
+  // `read_row(statement&) -> Row`.
+  template <class ReadRow>
+  auto fan_out(std::string_view sql, ReadRow read_row);
+
+  // Same as `fan_out`, but merges the shard results into one sorted sequence.
+  // |sql| must return rows sorted by |compare|.
+  template <class ReadRow, class Compare>
+  auto fan_out_sorted(std::string_view sql, ReadRow read_row, Compare compare);
+
+ private:
+  struct shard {
+    std::mutex mutex;
+    sql::sqlite3::connection connection;
+  };
+
+  // Returns the rows of every shard.
+  template <class ReadRow>
+  auto ReadShards(std::string_view sql, ReadRow& read_row);
+
+  std::vector<std::unique_ptr<shard>> shards_;
+};
+
+template <class Key, class F>
+inline decltype(auto) sharded_database::with_shard(const Key& key, F&& f) {
+  auto& shard = *shards_[shard_index(key)];
+  std::lock_guard lock{shard.mutex};
+  return std::forward<F>(f)(shard.connection);
+}
+
+template <class F>
+inline auto sharded_database::for_each_shard(F&& f) {
+  using result_type = std::invoke_result_t<F&, connection&, size_t>;
+
+  std::vector<std::future<result_type>> futures;
+  futures.reserve(shards_.size());
+
+  for (size_t i = 0; i < shards_.size(); ++i) {
+    futures.emplace_back(std::async(std::launch::async, [this, &f, i] {
+      auto& shard = *shards_[i];
+      std::lock_guard lock{shard.mutex};
+      return f(shard.connection, i);
+    }));
+  }
+
+  if constexpr (std::is_void_v<result_type>) {
+    for (auto& future : futures)
+      future.get();
+  } else {
+    std::vector<result_type> results;
+    results.reserve(futures.size());
+    for (auto& future : futures)
+      results.emplace_back(future.get());
+    return results;
+  }
+}
+
+template <class ReadRow>
+inline auto sharded_database::ReadShards(std::string_view sql,
+                                         ReadRow& read_row) {
+  using row_type = std::invoke_result_t<ReadRow&, statement&>;
+
+  return for_each_shard([sql, &read_row](connection& connection,
+                                         size_t /*shard_index*/) {
+    std::vector<row_type> rows;
+    statement statement{connection, sql};
+    while (statement.next())
+      rows.emplace_back(read_row(statement));
+    return rows;
+  });
+}
+
+template <class ReadRow>
+inline auto sharded_database::fan_out(std::string_view sql, ReadRow read_row) {
+  auto shard_rows = ReadShards(sql, read_row);
+
+  std::ranges::range_value_t<decltype(shard_rows)> rows;
+  for (auto& shard : shard_rows)
+    std::ranges::move(shard, std::back_inserter(rows));
+  return rows;
+}
+
+template <class ReadRow, class Compare>
+inline auto sharded_database::fan_out_sorted(std::string_view sql,
+                                             ReadRow read_row,
+                                             Compare compare) {
+  auto shard_rows = ReadShards(sql, read_row);
+
+  size_t row_count = 0;
+  for (auto& shard : shard_rows)
+    row_count += shard.size();
+
+  // K-way merge over the shard cursors.
+  using cursor = std::pair<size_t, size_t>;
+  auto greater = [&shard_rows, &compare](const cursor& a, const cursor& b) {
+    return compare(shard_rows[b.first][b.second],
+                   shard_rows[a.first][a.second]);
+  };
+
+  std::vector<cursor> heap;
+  for (size_t i = 0; i < shard_rows.size(); ++i) {
+    if (!shard_rows[i].empty())
+      heap.emplace_back(i, 0);
+  }
+  std::ranges::make_heap(heap, greater);
+
+  std::ranges::range_value_t<decltype(shard_rows)> rows;
+  rows.reserve(row_count);
+
+  while (!heap.empty()) {
+    std::ranges::pop_heap(heap, greater);
+    auto& [shard, index] = heap.back();
+    rows.emplace_back(std::move(shard_rows[shard][index]));
+    if (++index < shard_rows[shard].size())
+      std::ranges::push_heap(heap, greater);
+    else
+      heap.pop_back();
+  }
+
+  return rows;
+}
+
+}  // namespace sql::sqlite3
@@ -0,0 +1,57 @@
+#include "sql/sqlite3/sharded_database.h"
+
+#include "sql/test/temp_dir.h"
+
+#include <gmock/gmock.h>
+#include <numeric>
+
+using namespace testing;
+
+namespace sql::sqlite3 {
+
+TEST(ShardedDatabaseTest, RoutesAndFansOut) {
+  constexpr int kRowCount = 100;
+
+  ScopedTempDir temp_dir;
+  sharded_database database{temp_dir.get(), 4};
+  database.query_all("CREATE TABLE t(id INTEGER PRIMARY KEY, v TEXT)");
+
+  for (int64_t id = 0; id < kRowCount; ++id) {
+    database.with_shard(id, [id](connection& connection) {
+      statement insert{connection, "INSERT INTO t VALUES(?, ?)"};
+      insert.bind(0, id);
+      insert.bind(1, std::format("value {}", id));
+      insert.query();
+    });
+  }
+
+  // Every shard got some of the keys.
+  auto counts = database.for_each_shard([](connection& connection, size_t) {
+    statement count{connection, "SELECT COUNT(*) FROM t"};
+    count.next();
+    return count.at(0).as_int64();
+  });
+  EXPECT_THAT(counts, Each(Gt(0)));
+
+  // A point read goes to the shard owning the key.
+  auto value = database.with_shard(int64_t{42}, [](connection& connection) {
+    statement select{connection, "SELECT v FROM t WHERE id=42"};
+    return select.next() ? select.at(0).as_string() : std::string{};
+  });
+  EXPECT_EQ("value 42", value);
+
+  auto read_id = [](statement& statement) {
+    return statement.at(0).as_int64();
+  };
+
+  auto ids = database.fan_out("SELECT id FROM t", read_id);
+  EXPECT_EQ(static_cast<size_t>(kRowCount), ids.size());
+
+  auto sorted_ids = database.fan_out_sorted("SELECT id FROM t ORDER BY id",
+                                            read_id, std::less{});
+  std::vector<int64_t> expected(kRowCount);
+  std::iota(expected.begin(), expected.end(), 0);
+  EXPECT_THAT(sorted_ids, ElementsAreArray(expected));
+}
+
+}  // namespace sql::sqlite3
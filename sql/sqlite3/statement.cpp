@@ -2,9 +2,11 @@
 
 #include "sql/exception.h"
 #include "sql/sqlite3/connection.h"
+#include "sql/sqlite3/sqlite_util.h"
 
 #include <boost/locale/encoding_utf.hpp>
 #include <cassert>
+#include <new>
 #include <sqlite3.h>
 
 namespace sql::sqlite3 {
@@ -19,6 +21,87 @@ void CheckSqliteResult(::sqlite3* db, int result) {
   }
 }
 
+void BindParams(::sqlite3* db,
+                ::sqlite3_stmt* stmt,
+                std::span<const param_value> params,
+                sqlite3_destructor_type destructor) {
+  for (int i = 0; i < static_cast<int>(params.size()); ++i) {
+    const auto& param = params[i];
+    int result = SQLITE_OK;
+    if (param.is_null) {
+      result = sqlite3_bind_null(stmt, i + 1);
+    } else {
+      switch (param.type) {
+        case value_type::BOOL:
+          result = sqlite3_bind_int(stmt, i + 1, param.bool_value ? 1 : 0);
+          break;
+        case value_type::INT:
+          result = sqlite3_bind_int(stmt, i + 1, param.int_value);
+          break;
+        case value_type::INT64:
+          result = sqlite3_bind_int64(stmt, i + 1, param.int64_value);
+          break;
+        case value_type::DOUBLE:
+          result = sqlite3_bind_double(stmt, i + 1, param.double_value);
+          break;
+        case value_type::STRING_VIEW:
+        case value_type::STRING:
+          result = sqlite3_bind_text(
+              stmt, i + 1, param.string_value.data(),
+              static_cast<int>(param.string_value.size()), destructor);
+          break;
+        case value_type::STRING16: {
+          auto value = boost::locale::conv::utf_to_utf<char>(
+              param.string16_value.data(),
+              param.string16_value.data() + param.string16_value.size());
+          result = sqlite3_bind_text(stmt, i + 1, value.data(),
+                                     static_cast<int>(value.size()),
+                                     SQLITE_TRANSIENT);
+          break;
+        }
+      }
+    }
+    CheckSqliteResult(db, result);
+  }
+}
+
+// Same as `field_view`, but inlined into `statement::read_fields`.
+class ColumnView {
+ public:
+  ColumnView(::sqlite3_stmt* stmt, int index) : stmt_{stmt}, index_{index} {}
+
+  field_type type() const {
+    return static_cast<field_type>(sqlite3_column_type(stmt_, index_));
+  }
+
+  bool as_bool() const { return as_int() != 0; }
+  int as_int() const { return sqlite3_column_int(stmt_, index_); }
+  int64_t as_int64() const { return sqlite3_column_int64(stmt_, index_); }
+  double as_double() const { return sqlite3_column_double(stmt_, index_); }
+
+  std::string_view as_string_view() const {
+    const char* text =
+        reinterpret_cast<const char*>(sqlite3_column_text(stmt_, index_));
+    int length = sqlite3_column_bytes(stmt_, index_);
+    return text && length > 0
+               ? std::string_view{text, static_cast<size_t>(length)}
+               : std::string_view{};
+  }
+
+  std::string as_string() const { return std::string{as_string_view()}; }
+
+  std::u16string as_string16() const {
+    std::string_view string = as_string_view();
+    return string.empty() ? std::u16string()
+                          : boost::locale::conv::utf_to_utf<char16_t>(
+                                string.data(), string.data() + string.size());
+  }
+
+ private:
+  ::sqlite3_stmt* const stmt_;
+  const int index_;
+};
+
 }  // namespace
 
 // statement
@@ -43,6 +126,11 @@ void statement::prepare(connection& connection, std::string_view sql) {
   }
 
   connection_ = &connection;
+  columns_.reset();
+  batches_done_ = false;
+
+  if (connection.full_scan_handler_)
+    connection.CheckFullScans(sql);
 }
 
 void statement::bind_null(unsigned column) {
@@ -93,11 +181,105 @@ void statement::bind(unsigned column, std::u16string_view value) {
                    value.data(), value.data() + value.size()));
 }
 
+void statement::bind_params(std::span<const param_value> params) {
+  assert(stmt_);
+  BindParams(connection_->db_, stmt_, params, SQLITE_TRANSIENT);
+}
+
+void statement::bind_key_set(std::span<const param_value> keys) {
+  bind_params(keys);
+}
+
+int64_t statement::execute_batch(std::span<const param_value> params,
+                                 size_t row_count) {
+  assert(stmt_);
+  assert(row_count == 0 || params.size() % row_count == 0);
+
+  if (row_count == 0)
+    return 0;
+
+  ::sqlite3* db = connection_->db_;
+  size_t param_count = params.size() / row_count;
+  int64_t change_count = 0;
+
+  // |params| outlive each step, so the strings are bound without copying.
+  for (size_t row = 0; row < row_count; ++row) {
+    BindParams(db, stmt_, params.subspan(row * param_count, param_count),
+               SQLITE_STATIC);
+
+    int result;
+    do {
+      result = sqlite3_step(stmt_);
+    } while (result == SQLITE_ROW);
+
+    if (result != SQLITE_DONE) {
+      Exception error{sqlite3_errmsg(db)};
+      reset();
+      throw error;
+    }
+
+    change_count += sqlite3_changes(db);
+    sqlite3_reset(stmt_);
+  }
+
+  sqlite3_clear_bindings(stmt_);
+  return change_count;
+}
+
 size_t statement::field_count() const {
   assert(stmt_);
   return sqlite3_column_count(stmt_);
 }
 
+std::span<const column_info> statement::columns() const {
+  return GetColumns().get();
+}
+
+std::optional<unsigned> statement::find_column(std::string_view name) const {
+  return GetColumns().find(name);
+}
+
+const column_set& statement::GetColumns() const {
+  assert(stmt_);
+
+  if (!columns_) {
+    std::vector<column_info> columns(sqlite3_column_count(stmt_));
+    for (int i = 0; i < static_cast<int>(columns.size()); ++i) {
+      const char* name = sqlite3_column_name(stmt_, i);
+      if (!name)
+        throw std::bad_alloc{};
+      columns[i].name = name;
+      if (const char* declared_type = sqlite3_column_decltype(stmt_, i))
+        columns[i].declared_type = declared_type;
+      columns[i].nullable = GetColumnNullable(i);
+    }
+    columns_.emplace(std::move(columns));
+  }
+
+  return *columns_;
+}
+
+std::optional<bool> statement::GetColumnNullable(int column) const {
+#ifdef SQLITE_ENABLE_COLUMN_METADATA
+  // Only columns read directly from a table have an origin.
+  const char* database_name = sqlite3_column_database_name(stmt_, column);
+  const char* table_name = sqlite3_column_table_name(stmt_, column);
+  const char* origin_name = sqlite3_column_origin_name(stmt_, column);
+  if (!database_name || !table_name || !origin_name)
+    return std::nullopt;
+
+  int not_null = 0;
+  if (sqlite3_table_column_metadata(connection_->db_, database_name,
+                                    table_name, origin_name, nullptr, nullptr,
+                                    &not_null, nullptr, nullptr) != SQLITE_OK) {
+    return std::nullopt;
+  }
+  return !not_null;
+#else
+  return std::nullopt;
+#endif
+}
+
 field_type statement::type(unsigned column) const {
   // Verify that our enum matches sqlite's values.
   static_assert(static_cast<int>(sql::field_type::INTEGER) == SQLITE_INTEGER,
@@ -119,6 +301,15 @@ field_view statement::at(unsigned column) const {
   return field_view{stmt_, static_cast<int>(column)};
 }
 
+void statement::read_fields(std::span<const column_target> targets) const {
+  assert(stmt_);
+  assert(targets.size() <= field_count());
+  for (size_t i = 0; i < targets.size(); ++i) {
+    sql::internal::read_field(ColumnView{stmt_, static_cast<int>(i)},
+                              targets[i]);
+  }
+}
+
 void statement::query() {
   assert(stmt_);
   int result = sqlite3_step(stmt_);
@@ -143,6 +334,75 @@ void statement::reset() {
   assert(stmt_);
   sqlite3_clear_bindings(stmt_);
   sqlite3_reset(stmt_);
+  batches_done_ = false;
+}
+
+size_t statement::fetch_batch(column_batch& batch, size_t max_rows) {
+  assert(stmt_);
+
+  int column_count = sqlite3_column_count(stmt_);
+  batch.clear(column_count);
+
+  for (int i = 0; i < column_count; ++i) {
+    auto& column = batch.column(i);
+    if (column.type() != field_type::EMPTY)
+      continue;
+    if (const char* declared_type = sqlite3_column_decltype(stmt_, i)) {
+      if (auto type = parse_field_type(declared_type);
+          type != field_type::EMPTY) {
+        column.set_type(type);
+      }
+    }
+  }
+
+  // SQLite restarts a finished statement on the next step.
+  if (batches_done_)
+    return 0;
+
+  while (batch.row_count() < max_rows) {
+    if (!next()) {
+      batches_done_ = true;
+      break;
+    }
+
+    for (int i = 0; i < column_count; ++i) {
+      auto& column = batch.column(i);
+      int type = sqlite3_column_type(stmt_, i);
+      if (type == SQLITE_NULL) {
+        column.append_null();
+        continue;
+      }
+
+      if (column.type() == field_type::EMPTY)
+        column.set_type(static_cast<field_type>(type));
+
+      switch (column.type()) {
+        case field_type::INTEGER:
+          column.append_integer(sqlite3_column_int64(stmt_, i));
+          break;
+        case field_type::FLOAT:
+          column.append_float(sqlite3_column_double(stmt_, i));
+          break;
+        case field_type::TEXT:
+          column.append_string(ColumnView{stmt_, i}.as_string_view());
+          break;
+        case field_type::BLOB: {
+          const void* blob = sqlite3_column_blob(stmt_, i);
+          int size = sqlite3_column_bytes(stmt_, i);
+          column.append_string(
+              blob ? std::string_view{static_cast<const char*>(blob),
+                                      static_cast<size_t>(size)}
+                   : std::string_view{});
+          break;
+        }
+        case field_type::EMPTY:
+          break;
+      }
+    }
+    batch.end_row();
+  }
+
+  return batch.row_count();
 }
 
 void statement::close() {
@@ -150,6 +410,31 @@ void statement::close() {
     sqlite3_finalize(stmt_);
     stmt_ = nullptr;
   }
+  columns_.reset();
+  batches_done_ = false;
+}
+
+statement_status statement::status(bool reset) const {
+  assert(stmt_);
+
+  int reset_flag = reset ? 1 : 0;
+  auto get = [this, reset_flag](int op) {
+    return sqlite3_stmt_status(stmt_, op, reset_flag);
+  };
+
+  return {.fullscan_steps = get(SQLITE_STMTSTATUS_FULLSCAN_STEP),
+          .sorts = get(SQLITE_STMTSTATUS_SORT),
+          .autoindex_steps = get(SQLITE_STMTSTATUS_AUTOINDEX),
+          .vm_steps = get(SQLITE_STMTSTATUS_VM_STEP),
+          .reprepares = get(SQLITE_STMTSTATUS_REPREPARE),
+          .runs = get(SQLITE_STMTSTATUS_RUN),
+          .memory_used =
+              sqlite3_stmt_status(stmt_, SQLITE_STMTSTATUS_MEMUSED, 0)};
+}
+
+query_plan statement::explain() const {
+  assert(stmt_);
+  return connection_->explain(sqlite3_sql(stmt_));
 }
 
 }  // namespace sql::sqlite3
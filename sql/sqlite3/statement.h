@@ -1,9 +1,17 @@
 #pragma once
 
+#include "sql/column_batch.h"
+#include "sql/column_set.h"
+#include "sql/param.h"
+#include "sql/row.h"
 #include "sql/sqlite3/field_view.h"
+#include "sql/sqlite3/status.h"
 #include "sql/types.h"
 
+#include <optional>
+#include <span>
 #include <string>
+#include <tuple>
 
 struct sqlite3_stmt;
 
@@ -35,19 +43,92 @@ class statement {
   void bind(unsigned column, std::string_view value);
   void bind(unsigned column, std::u16string_view value);
 
+  // Binds |params| to the parameters from the first one with a single driver
+  // call.
+  void bind_params(std::span<const param_value> params);
+
+  // Binds |keys| to a statement prepared from `connection::key_set_sql`.
+  void bind_key_set(std::span<const param_value> keys);
+
+  // Binds |args| to the parameters in order. An empty `std::optional` binds
+  // NULL.
+  template <class... Args>
+  void bind_all(const Args&... args) {
+    sql::internal::bind_all(*this, args...);
+  }
+
+  // Binds |args|, runs the statement and resets it.
+  template <class... Args>
+  void execute(const Args&... args) {
+    sql::internal::execute(*this, args...);
+  }
+
+  // Runs the statement once per element of |rows|, a range of tuples or
+  // aggregates, and returns the affected row count of each driver call.
+  template <std::ranges::input_range Rows>
+  std::vector<int64_t> execute_batch(Rows&& rows) {
+    return sql::internal::execute_batch(*this, std::forward<Rows>(rows));
+  }
+
+  // Runs the statement |row_count| times, binding consecutive equal slices of
+  // |params|, with a single driver call. Returns the total affected row count.
+  int64_t execute_batch(std::span<const param_value> params, size_t row_count);
+
   size_t field_count() const;
+
+  // Describes the result columns. Computed once per prepared statement.
+  std::span<const column_info> columns() const;
+  // Returns the index of the result column named |name|.
+  std::optional<unsigned> find_column(std::string_view name) const;
   field_type type(unsigned column) const;
   field_view at(unsigned column) const;
 
+  // Decodes the current row into |targets| with a single driver call.
+  void read_fields(std::span<const column_target> targets) const;
+
+  // Reads the current row as a tuple. NULL values map to empty
+  // `std::optional`s and to default values of other types.
+  template <class... Ts>
+  std::tuple<Ts...> read_row() const {
+    std::tuple<Ts...> row;
+    sql::internal::read_row(*this, row);
+    return row;
+  }
+
+  // Fills the members of the aggregate |row| in declaration order.
+  template <class Row>
+  void read_row(Row& row) const {
+    sql::internal::read_row(*this, row);
+  }
+
   void query();
   bool next();
   void reset();
 
+  // Reads up to |max_rows| rows into |batch| and returns their count, which is
+  // 0 once the rows are exhausted. See `column_batch`.
+  size_t fetch_batch(column_batch& batch, size_t max_rows);
+
   void close();
 
+  // Resets the resettable counters after reading them if |reset| is set.
+  statement_status status(bool reset = false) const;
+
+  query_plan explain() const;
+
  private:
-  connection* connection_;
-  ::sqlite3_stmt* stmt_;
+  const column_set& GetColumns() const;
+  // Unset unless |column| is read directly from a table.
+  std::optional<bool> GetColumnNullable(int column) const;
+
+  connection* connection_ = nullptr;
+  ::sqlite3_stmt* stmt_ = nullptr;
+
+  // Set once `fetch_batch` reaches the end of the rows.
+  bool batches_done_ = false;
+
+  // Computed on first use.
+  mutable std::optional<column_set> columns_;
 };
 
 }  // namespace sql::sqlite3
@@ -0,0 +1,33 @@
+#pragma once
+
+namespace sql::sqlite3 {
+
+// Counters from `sqlite3_stmt_status`.
+struct statement_status {
+  // Rows stepped through in full table scans. Large values suggest a missing
+  // index.
+  int fullscan_steps = 0;
+  int sorts = 0;
+  // Rows inserted into automatic indexes.
+  int autoindex_steps = 0;
+  int vm_steps = 0;
+  int reprepares = 0;
+  int runs = 0;
+  // Bytes used by the prepared statement. Never reset.
+  int memory_used = 0;
+};
+
+// Figures from `sqlite3_db_status`. Byte counts are for the current moment;
+// cache hit, miss, write and spill counts accumulate until reset.
+struct connection_status {
+  int cache_used = 0;
+  int cache_hits = 0;
+  int cache_misses = 0;
+  int cache_writes = 0;
+  int cache_spills = 0;
+  int schema_used = 0;
+  int statement_used = 0;
+  int lookaside_used = 0;
+};
+
+}  // namespace sql::sqlite3
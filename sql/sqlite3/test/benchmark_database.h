@@ -0,0 +1,43 @@
+#pragma once
+
+#include "sql/sqlite3/connection.h"
+#include "sql/sqlite3/statement.h"
+#include "sql/test/temp_dir.h"
+
+#include <format>
+
+namespace sql::sqlite3 {
+
+// A database with the table `t(id, a, b)`, opened with |params| in a unique
+// temp directory, which is removed on destruction. The temp directory should
+// be on the device to measure.
+class BenchmarkDatabase {
+ public:
+  explicit BenchmarkDatabase(open_params params) {
+    params.path = temp_dir_.get() / "benchmark.sqlite3";
+    connection_.open(params);
+    connection_.query(
+        "CREATE TABLE t(id INTEGER PRIMARY KEY, a INTEGER, b TEXT)");
+  }
+
+  connection& get() { return connection_; }
+
+  void Populate(int row_count) {
+    statement insert{connection_, "INSERT INTO t(a, b) VALUES(?, ?)"};
+    connection_.start();
+    for (int i = 0; i < row_count; ++i) {
+      insert.bind(0, (i * 7919) % row_count);
+      insert.bind(1, std::format("value {}", i));
+      insert.query();
+      insert.reset();
+    }
+    connection_.commit();
+  }
+
+ private:
+  // Outlives the connection.
+  ScopedTempDir temp_dir_;
+  connection connection_;
+};
+
+}  // namespace sql::sqlite3
@@ -0,0 +1,907 @@
+#include "sql/sqlite3/uring_vfs.h"
+
+#include "sql/exception.h"
+
+#include <sqlite3.h>
+
+#if defined(__linux__)
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <linux/io_uring.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <span>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#endif
+
+namespace sql::sqlite3 {
+
+#if defined(__linux__)
+
+namespace {
+
+// A minimal io_uring instance driven through the raw system calls.
+class Ring {
+ public:
+  // Returns null if the kernel does not support io_uring.
+  static std::unique_ptr<Ring> Create(unsigned entries);
+
+  ~Ring();
+
+  Ring(const Ring&) = delete;
+  Ring& operator=(const Ring&) = delete;
+
+  unsigned capacity() const { return sq_entries_; }
+
+  // Returns a cleared entry, or null if the submission queue is full.
+  io_uring_sqe* GetSqe();
+
+  // Submits the queued entries and waits for all of them to complete. Stores
+  // the completion results in |results| indexed by `user_data`.
+  bool SubmitAndWait(std::span<int> results);
+
+ private:
+  Ring() = default;
+
+  static unsigned LoadAcquire(const unsigned* p) {
+    return std::atomic_ref{*const_cast<unsigned*>(p)}.load(
+        std::memory_order_acquire);
+  }
+
+  static void StoreRelease(unsigned* p, unsigned value) {
+    std::atomic_ref{*p}.store(value, std::memory_order_release);
+  }
+
+  unsigned Reap(std::span<int> results);
+
+  int fd_ = -1;
+
+  void* sq_ring_ = MAP_FAILED;
+  size_t sq_ring_size_ = 0;
+  void* cq_ring_ = MAP_FAILED;
+  size_t cq_ring_size_ = 0;
+  io_uring_sqe* sqes_ = static_cast<io_uring_sqe*>(MAP_FAILED);
+  size_t sqes_size_ = 0;
+
+  unsigned* sq_head_ = nullptr;
+  unsigned* sq_tail_ = nullptr;
+  unsigned* sq_array_ = nullptr;
+  unsigned sq_mask_ = 0;
+  unsigned sq_entries_ = 0;
+  // Tail including the entries not submitted yet.
+  unsigned sq_local_tail_ = 0;
+  unsigned queued_count_ = 0;
+
+  unsigned* cq_head_ = nullptr;
+  unsigned* cq_tail_ = nullptr;
+  unsigned cq_mask_ = 0;
+  io_uring_cqe* cqes_ = nullptr;
+};
+
+std::unique_ptr<Ring> Ring::Create(unsigned entries) {
+  io_uring_params params = {};
+  int fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+  if (fd < 0)
+    return nullptr;
+
+  std::unique_ptr<Ring> ring{new Ring};
+  ring->fd_ = fd;
+
+  ring->sq_ring_size_ =
+      params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  ring->cq_ring_size_ =
+      params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+  if (single_mmap) {
+    ring->sq_ring_size_ = ring->cq_ring_size_ =
+        std::max(ring->sq_ring_size_, ring->cq_ring_size_);
+  }
+
+  ring->sq_ring_ = mmap(nullptr, ring->sq_ring_size_, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+  if (ring->sq_ring_ == MAP_FAILED)
+    return nullptr;
+
+  if (single_mmap) {
+    ring->cq_ring_ = ring->sq_ring_;
+  } else {
+    ring->cq_ring_ =
+        mmap(nullptr, ring->cq_ring_size_, PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    if (ring->cq_ring_ == MAP_FAILED)
+      return nullptr;
+  }
+
+  ring->sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+  ring->sqes_ = static_cast<io_uring_sqe*>(
+      mmap(nullptr, ring->sqes_size_, PROT_READ | PROT_WRITE,
+           MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+  if (ring->sqes_ == MAP_FAILED)
+    return nullptr;
+
+  auto* sq = static_cast<std::byte*>(ring->sq_ring_);
+  ring->sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+  ring->sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+  ring->sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+  ring->sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+  ring->sq_entries_ = params.sq_entries;
+  ring->sq_local_tail_ = *ring->sq_tail_;
+
+  auto* cq = static_cast<std::byte*>(ring->cq_ring_);
+  ring->cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+  ring->cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+  ring->cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+  ring->cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+  return ring;
+}
+
+Ring::~Ring() {
+  if (sqes_ != MAP_FAILED)
+    munmap(sqes_, sqes_size_);
+  if (cq_ring_ != MAP_FAILED && cq_ring_ != sq_ring_)
+    munmap(cq_ring_, cq_ring_size_);
+  if (sq_ring_ != MAP_FAILED)
+    munmap(sq_ring_, sq_ring_size_);
+  if (fd_ >= 0)
+    close(fd_);
+}
+
+io_uring_sqe* Ring::GetSqe() {
+  if (sq_local_tail_ - LoadAcquire(sq_head_) >= sq_entries_)
+    return nullptr;
+
+  unsigned index = sq_local_tail_ & sq_mask_;
+  sq_array_[index] = index;
+  auto* sqe = &sqes_[index];
+  std::memset(sqe, 0, sizeof(*sqe));
+
+  ++sq_local_tail_;
+  ++queued_count_;
+  return sqe;
+}
+
+bool Ring::SubmitAndWait(std::span<int> results) {
+  StoreRelease(sq_tail_, sq_local_tail_);
+
+  unsigned total = std::exchange(queued_count_, 0);
+  unsigned submitted = 0;
+  unsigned completed = 0;
+
+  while (completed < total) {
+    // The kernel does not wait if it accepts only part of the entries.
+    int result = static_cast<int>(
+        syscall(__NR_io_uring_enter, fd_, total - submitted, total - completed,
+                IORING_ENTER_GETEVENTS, nullptr, 0));
+    if (result < 0) {
+      if (errno == EINTR || errno == EAGAIN || errno == EBUSY)
+        continue;
+      return false;
+    }
+
+    submitted += result;
+    completed += Reap(results);
+  }
+
+  return true;
+}
+
+unsigned Ring::Reap(std::span<int> results) {
+  unsigned head = *cq_head_;
+  unsigned tail = LoadAcquire(cq_tail_);
+  unsigned count = tail - head;
+
+  for (; head != tail; ++head) {
+    const auto& cqe = cqes_[head & cq_mask_];
+    if (cqe.user_data < results.size())
+      results[cqe.user_data] = cqe.res;
+  }
+
+  StoreRelease(cq_head_, head);
+  return count;
+}
+
+uring_vfs_options vfs_options;
+sqlite3_vfs uring_vfs;
+
+// Whether the kernel supports io_uring, probed on registration.
+std::atomic<bool> ring_available = false;
+
+std::atomic<int64_t> uring_file_count = 0;
+std::atomic<int64_t> submission_count = 0;
+
+sqlite3_vfs* GetBaseVfs(sqlite3_vfs* vfs) {
+  return static_cast<sqlite3_vfs*>(vfs->pAppData);
+}
+
+// Each thread submits through its own ring, so that the connections of
+// different threads wait for their requests in parallel. Returns null if the
+// ring cannot be created, e.g. over the locked memory limit.
+Ring* GetThreadRing() {
+  thread_local std::unique_ptr<Ring> ring;
+  thread_local bool created = false;
+  if (!std::exchange(created, true))
+    ring = Ring::Create(vfs_options.queue_depth);
+  return ring.get();
+}
+
+struct FileState {
+  // The file of the default VFS.
+  sqlite3_file* real = nullptr;
+
+  // The descriptor of |real|. Negative for files left to the default VFS.
+  int fd = -1;
+
+  // Links a main database file and its WAL, whose frames must be written out
+  // before the WAL index of the main database file publishes them.
+  FileState* wal = nullptr;
+  FileState* main = nullptr;
+  // The name of a main database file, its key in |main_files|.
+  const char* main_name = nullptr;
+
+  // A flush error of `xShmBarrier`, which cannot fail. Returned by the next
+  // call that can.
+  int deferred_error = SQLITE_OK;
+
+  // The default VFS syncs the directory on the first sync of a journal it
+  // created, so that sync is delegated to it.
+  bool base_sync_pending = false;
+
+  // Buffered writes keyed by file offset. Adjacent writes are merged.
+  std::map<sqlite3_int64, std::vector<std::byte>> pending_writes;
+  size_t pending_bytes = 0;
+
+  std::vector<int> results;
+};
+
+struct UringFile {
+  sqlite3_file base;
+  FileState* state;
+};
+
+// The file of the default VFS follows |UringFile|.
+constexpr size_t kRealFileOffset =
+    (sizeof(UringFile) + alignof(std::max_align_t) - 1) &
+    ~(alignof(std::max_align_t) - 1);
+
+// Main database files keyed by the name passed to `xOpen`. SQLite passes the
+// same pointer for a WAL through `sqlite3_filename_database`.
+std::mutex files_mutex;
+std::unordered_map<const char*, FileState*> main_files;
+
+FileState& GetState(sqlite3_file* file) {
+  return *reinterpret_cast<UringFile*>(file)->state;
+}
+
+int TakeDeferredError(FileState& state) {
+  return std::exchange(state.deferred_error, SQLITE_OK);
+}
+
+// The unix VFS keeps the descriptor after three pointers in its file object.
+// A descriptor opened separately would drop the POSIX locks of the unix VFS
+// when closed, so its own descriptor is used. Returns -1, so that the file is
+// left to the default VFS, unless the layout matches: the second pointer is
+// the VFS and the descriptor refers to the opened path.
+int GetDescriptor(sqlite3_file* real,
+                  const sqlite3_vfs* base_vfs,
+                  const char* path) {
+  struct UnixFile {
+    const sqlite3_io_methods* methods;
+    const sqlite3_vfs* vfs;
+    void* inode;
+    int fd;
+  };
+
+  const auto& unix_file = *reinterpret_cast<UnixFile*>(real);
+  if (unix_file.vfs != base_vfs)
+    return -1;
+
+  int fd = unix_file.fd;
+
+  struct stat fd_stat = {};
+  struct stat path_stat = {};
+  if (fstat(fd, &fd_stat) != 0 || stat(path, &path_stat) != 0 ||
+      fd_stat.st_dev != path_stat.st_dev ||
+      fd_stat.st_ino != path_stat.st_ino) {
+    return -1;
+  }
+
+  return fd;
+}
+
+int GetWriteError(int error) {
+  return error == ENOSPC ? SQLITE_FULL : SQLITE_IOERR_WRITE;
+}
+
+int GetSyncError(int error) {
+  return error == ENOSPC ? SQLITE_FULL : SQLITE_IOERR_FSYNC;
+}
+
+int WriteFully(int fd, const std::byte* data, size_t size, off_t offset) {
+  while (size != 0) {
+    auto written = pwrite(fd, data, size, offset);
+    if (written < 0) {
+      if (errno == EINTR)
+        continue;
+      return GetWriteError(errno);
+    }
+    data += written;
+    size -= written;
+    offset += written;
+  }
+  return SQLITE_OK;
+}
+
+// Writes out the buffered writes synchronously, for threads without a ring.
+int FlushDirectly(FileState& state, bool sync) {
+  for (const auto& [offset, data] : state.pending_writes) {
+    if (int result = WriteFully(state.fd, data.data(), data.size(), offset);
+        result != SQLITE_OK) {
+      return result;
+    }
+  }
+  if (sync && fdatasync(state.fd) != 0)
+    return GetSyncError(errno);
+
+  state.pending_writes.clear();
+  state.pending_bytes = 0;
+  return SQLITE_OK;
+}
+
+// Submits the buffered writes in batches that fit |ring|.
+int FlushThroughRing(Ring& ring, FileState& state, bool sync) {
+  auto run = state.pending_writes.begin();
+  std::vector<decltype(run)> batch;
+
+  do {
+    // Leaves room for the fdatasync.
+    batch.clear();
+    while (run != state.pending_writes.end() &&
+           batch.size() + 1 < ring.capacity()) {
+      batch.emplace_back(run++);
+    }
+
+    bool sync_batch = sync && run == state.pending_writes.end();
+
+    for (size_t i = 0; i < batch.size(); ++i) {
+      const auto& [offset, data] = *batch[i];
+      auto* sqe = ring.GetSqe();
+      sqe->opcode = IORING_OP_WRITE;
+      sqe->fd = state.fd;
+      sqe->addr = reinterpret_cast<uintptr_t>(data.data());
+      sqe->len = static_cast<unsigned>(data.size());
+      sqe->off = static_cast<uint64_t>(offset);
+      sqe->user_data = i;
+      // The chain runs the writes in order and the fdatasync after them.
+      if (sync_batch)
+        sqe->flags = IOSQE_IO_LINK;
+    }
+
+    if (sync_batch) {
+      auto* sqe = ring.GetSqe();
+      sqe->opcode = IORING_OP_FSYNC;
+      sqe->fd = state.fd;
+      sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+      sqe->user_data = batch.size();
+    }
+
+    state.results.assign(batch.size() + (sync_batch ? 1 : 0), 0);
+    submission_count += state.results.size();
+    if (!ring.SubmitAndWait(state.results))
+      return sync ? SQLITE_IOERR_FSYNC : SQLITE_IOERR_WRITE;
+
+    // A short write cancels the rest of the chain. Completes it synchronously.
+    bool rewritten = false;
+    for (size_t i = 0; i < batch.size(); ++i) {
+      const auto& [offset, data] = *batch[i];
+      int result = state.results[i];
+      if (result == static_cast<int>(data.size()))
+        continue;
+
+      if (result == -ENOSPC)
+        return SQLITE_FULL;
+      size_t done = result > 0 ? result : 0;
+      if (int error = WriteFully(state.fd, data.data() + done,
+                                 data.size() - done, offset + done);
+          error != SQLITE_OK) {
+        return error;
+      }
+      rewritten = true;
+    }
+
+    if (sync_batch && (rewritten || state.results.back() != 0)) {
+      if (fdatasync(state.fd) != 0)
+        return GetSyncError(errno);
+    }
+  } while (run != state.pending_writes.end());
+
+  state.pending_writes.clear();
+  state.pending_bytes = 0;
+  return SQLITE_OK;
+}
+
+// Writes out the buffered writes. With |sync| they are followed by a
+// fdatasync, which is issued even if nothing is buffered.
+int Flush(FileState& state, bool sync) {
+  if (state.fd < 0 || (state.pending_writes.empty() && !sync))
+    return SQLITE_OK;
+
+  auto* ring = GetThreadRing();
+  if (!ring)
+    return FlushDirectly(state, sync);
+
+  try {
+    return FlushThroughRing(*ring, state, sync);
+  } catch (const std::bad_alloc&) {
+    return SQLITE_IOERR_NOMEM;
+  }
+}
+
+bool OverlapsPendingWrites(const FileState& state,
+                           sqlite3_int64 offset,
+                           int size) {
+  auto next = state.pending_writes.lower_bound(offset + size);
+  if (next == state.pending_writes.begin())
+    return false;
+  auto prev = std::prev(next);
+  return prev->first + static_cast<sqlite3_int64>(prev->second.size()) >
+         offset;
+}
+
+// Returns false if the write partially overlaps the buffered ones.
+bool BufferWrite(FileState& state,
+                 const std::byte* data,
+                 int size,
+                 sqlite3_int64 offset) {
+  auto& pending = state.pending_writes;
+  auto next = pending.upper_bound(offset);
+  auto run = pending.end();
+
+  if (next != pending.begin()) {
+    auto prev = std::prev(next);
+    auto prev_end =
+        prev->first + static_cast<sqlite3_int64>(prev->second.size());
+    if (prev_end >= offset + size) {
+      // Rewrites buffered pages.
+      std::memcpy(prev->second.data() + (offset - prev->first), data, size);
+      return true;
+    }
+    if (prev_end > offset)
+      return false;
+    if (prev_end == offset)
+      run = prev;
+  }
+
+  if (next != pending.end() && next->first < offset + size)
+    return false;
+
+  if (run != pending.end()) {
+    run->second.insert(run->second.end(), data, data + size);
+  } else {
+    run = pending.emplace_hint(next, offset,
+                               std::vector<std::byte>{data, data + size});
+  }
+  state.pending_bytes += size;
+
+  // Joins the following run if the gap is closed.
+  if (next != pending.end() &&
+      run->first + static_cast<sqlite3_int64>(run->second.size()) ==
+          next->first) {
+    run->second.insert(run->second.end(), next->second.begin(),
+                       next->second.end());
+    pending.erase(next);
+  }
+
+  return true;
+}
+
+int Close(sqlite3_file* file) {
+  auto* state = &GetState(file);
+  int result = Flush(*state, false);
+
+  {
+    std::lock_guard lock{files_mutex};
+    if (state->main_name)
+      main_files.erase(state->main_name);
+    if (state->wal)
+      state->wal->main = nullptr;
+    if (state->main)
+      state->main->wal = nullptr;
+  }
+
+  int close_result = state->real->pMethods->xClose(state->real);
+  delete state;
+  return result != SQLITE_OK ? result : close_result;
+}
+
+int Read(sqlite3_file* file, void* buffer, int size, sqlite3_int64 offset) {
+  auto& state = GetState(file);
+  if (state.fd >= 0 && OverlapsPendingWrites(state, offset, size)) {
+    if (Flush(state, false) != SQLITE_OK)
+      return SQLITE_IOERR_READ;
+  }
+
+  auto* ring = state.fd >= 0 ? GetThreadRing() : nullptr;
+  if (!ring)
+    return state.real->pMethods->xRead(state.real, buffer, size, offset);
+
+  auto* data = static_cast<std::byte*>(buffer);
+  int done = 0;
+  while (done < size) {
+    auto* sqe = ring->GetSqe();
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = state.fd;
+    sqe->addr = reinterpret_cast<uintptr_t>(data + done);
+    sqe->len = static_cast<unsigned>(size - done);
+    sqe->off = static_cast<uint64_t>(offset + done);
+
+    int result = 0;
+    ++submission_count;
+    if (!ring->SubmitAndWait(std::span{&result, 1}))
+      return SQLITE_IOERR_READ;
+
+    if (result == -EINTR || result == -EAGAIN)
+      continue;
+    if (result < 0)
+      return SQLITE_IOERR_READ;
+    if (result == 0) {
+      // SQLite requires the missing part to be zero-filled.
+      std::memset(data + done, 0, size - done);
+      return SQLITE_IOERR_SHORT_READ;
+    }
+    done += result;
+  }
+
+  return SQLITE_OK;
+}
+
+int Write(sqlite3_file* file,
+          const void* buffer,
+          int size,
+          sqlite3_int64 offset) {
+  auto& state = GetState(file);
+  if (state.fd < 0)
+    return state.real->pMethods->xWrite(state.real, buffer, size, offset);
+
+  auto* data = static_cast<const std::byte*>(buffer);
+  try {
+    if (!BufferWrite(state, data, size, offset)) {
+      if (int result = Flush(state, false); result != SQLITE_OK)
+        return result;
+      BufferWrite(state, data, size, offset);
+    }
+  } catch (const std::bad_alloc&) {
+    // Leaves the buffer as it was. Writes out the buffered writes, then this
+    // one directly.
+    if (int result = Flush(state, false); result != SQLITE_OK)
+      return result;
+    return WriteFully(state.fd, data, size, offset);
+  }
+
+  if (state.pending_bytes >= vfs_options.max_pending_bytes)
+    return Flush(state, false);
+
+  return SQLITE_OK;
+}
+
+int Truncate(sqlite3_file* file, sqlite3_int64 size) {
+  auto& state = GetState(file);
+  if (int result = Flush(state, false); result != SQLITE_OK)
+    return result;
+  return state.real->pMethods->xTruncate(state.real, size);
+}
+
+int Sync(sqlite3_file* file, int flags) {
+  auto& state = GetState(file);
+  if (int result = TakeDeferredError(state); result != SQLITE_OK)
+    return result;
+  if (state.fd < 0)
+    return state.real->pMethods->xSync(state.real, flags);
+
+  if (state.base_sync_pending) {
+    if (int result = Flush(state, false); result != SQLITE_OK)
+      return result;
+    state.base_sync_pending = false;
+    return state.real->pMethods->xSync(state.real, flags);
+  }
+
+  return Flush(state, true);
+}
+
+int FileSize(sqlite3_file* file, sqlite3_int64* size) {
+  auto& state = GetState(file);
+  int result = state.real->pMethods->xFileSize(state.real, size);
+  if (result == SQLITE_OK && !state.pending_writes.empty()) {
+    const auto& [offset, data] = *state.pending_writes.rbegin();
+    *size = std::max(*size, offset + static_cast<sqlite3_int64>(data.size()));
+  }
+  return result;
+}
+
+int Lock(sqlite3_file* file, int lock) {
+  auto& state = GetState(file);
+  if (int result = TakeDeferredError(state); result != SQLITE_OK)
+    return result;
+  if (int result = Flush(state, false); result != SQLITE_OK)
+    return result;
+  return state.real->pMethods->xLock(state.real, lock);
+}
+
+int Unlock(sqlite3_file* file, int lock) {
+  auto& state = GetState(file);
+  if (int result = Flush(state, false); result != SQLITE_OK)
+    return result;
+  return state.real->pMethods->xUnlock(state.real, lock);
+}
+
+int CheckReservedLock(sqlite3_file* file, int* result) {
+  auto& state = GetState(file);
+  return state.real->pMethods->xCheckReservedLock(state.real, result);
+}
+
+int FileControl(sqlite3_file* file, int op, void* arg) {
+  auto& state = GetState(file);
+  if (int result = Flush(state, false); result != SQLITE_OK)
+    return result;
+  return state.real->pMethods->xFileControl(state.real, op, arg);
+}
+
+int SectorSize(sqlite3_file* file) {
+  auto& state = GetState(file);
+  return state.real->pMethods->xSectorSize(state.real);
+}
+
+int DeviceCharacteristics(sqlite3_file* file) {
+  auto& state = GetState(file);
+  return state.real->pMethods->xDeviceCharacteristics(state.real);
+}
+
+int ShmMap(sqlite3_file* file,
+           int page,
+           int page_size,
+           int extend,
+           void volatile** p) {
+  auto& state = GetState(file);
+  return state.real->pMethods->xShmMap(state.real, page, page_size, extend, p);
+}
+
+int ShmLock(sqlite3_file* file, int offset, int count, int flags) {
+  auto& state = GetState(file);
+  // Unlocking must not fail, or the lock would leak.
+  if (!(flags & SQLITE_SHM_UNLOCK)) {
+    if (int result = TakeDeferredError(state); result != SQLITE_OK)
+      return result;
+  }
+  if (int result = Flush(state, false); result != SQLITE_OK)
+    return result;
+  return state.real->pMethods->xShmLock(state.real, offset, count, flags);
+}
+
+void ShmBarrier(sqlite3_file* file) {
+  // WAL frames must reach the file before the WAL index publishes them.
+  auto& state = GetState(file);
+  int result = state.wal ? Flush(*state.wal, false) : SQLITE_OK;
+  if (result == SQLITE_OK)
+    result = Flush(state, false);
+  if (result != SQLITE_OK && state.deferred_error == SQLITE_OK)
+    state.deferred_error = result;
+  state.real->pMethods->xShmBarrier(state.real);
+}
+
+int ShmUnmap(sqlite3_file* file, int delete_flag) {
+  auto& state = GetState(file);
+  return state.real->pMethods->xShmUnmap(state.real, delete_flag);
+}
+
+int Fetch(sqlite3_file* file, sqlite3_int64 offset, int size, void** p) {
+  auto& state = GetState(file);
+  if (int result = Flush(state, false); result != SQLITE_OK)
+    return result;
+  return state.real->pMethods->xFetch(state.real, offset, size, p);
+}
+
+int Unfetch(sqlite3_file* file, sqlite3_int64 offset, void* p) {
+  auto& state = GetState(file);
+  return state.real->pMethods->xUnfetch(state.real, offset, p);
+}
+
+const sqlite3_io_methods kIoMethods = {.iVersion = 3,
+                                       .xClose = &Close,
+                                       .xRead = &Read,
+                                       .xWrite = &Write,
+                                       .xTruncate = &Truncate,
+                                       .xSync = &Sync,
+                                       .xFileSize = &FileSize,
+                                       .xLock = &Lock,
+                                       .xUnlock = &Unlock,
+                                       .xCheckReservedLock = &CheckReservedLock,
+                                       .xFileControl = &FileControl,
+                                       .xSectorSize = &SectorSize,
+                                       .xDeviceCharacteristics =
+                                           &DeviceCharacteristics,
+                                       .xShmMap = &ShmMap,
+                                       .xShmLock = &ShmLock,
+                                       .xShmBarrier = &ShmBarrier,
+                                       .xShmUnmap = &ShmUnmap,
+                                       .xFetch = &Fetch,
+                                       .xUnfetch = &Unfetch};
+
+int Open(sqlite3_vfs* vfs,
+         const char* name,
+         sqlite3_file* file,
+         int flags,
+         int* out_flags) {
+  auto* base_vfs = GetBaseVfs(vfs);
+  auto* real = reinterpret_cast<sqlite3_file*>(
+      reinterpret_cast<std::byte*>(file) + kRealFileOffset);
+  file->pMethods = nullptr;
+
+  int result = base_vfs->xOpen(base_vfs, name, real, flags, out_flags);
+  if (result != SQLITE_OK) {
+    if (real->pMethods)
+      real->pMethods->xClose(real);
+    return result;
+  }
+
+  auto* state = new (std::nothrow) FileState{.real = real};
+  if (!state) {
+    real->pMethods->xClose(real);
+    return SQLITE_NOMEM;
+  }
+
+  constexpr int kUringFileTypes =
+      SQLITE_OPEN_MAIN_DB | SQLITE_OPEN_MAIN_JOURNAL | SQLITE_OPEN_WAL;
+  constexpr int kDirectorySyncFileTypes =
+      SQLITE_OPEN_MAIN_JOURNAL | SQLITE_OPEN_SUPER_JOURNAL | SQLITE_OPEN_WAL;
+
+  if (ring_available && name && (flags & kUringFileTypes) &&
+      !(flags & SQLITE_OPEN_DELETEONCLOSE)) {
+    state->fd = GetDescriptor(real, base_vfs, name);
+    if (state->fd >= 0)
+      ++uring_file_count;
+  }
+
+  if (name && (flags & SQLITE_OPEN_MAIN_DB)) {
+    std::lock_guard lock{files_mutex};
+    state->main_name = name;
+    main_files.insert_or_assign(name, state);
+  } else if (name && (flags & SQLITE_OPEN_WAL)) {
+    std::lock_guard lock{files_mutex};
+    auto i = main_files.find(sqlite3_filename_database(name));
+    if (i != main_files.end()) {
+      state->main = i->second;
+      i->second->wal = state;
+    }
+  }
+
+  state->base_sync_pending =
+      (flags & SQLITE_OPEN_CREATE) && (flags & kDirectorySyncFileTypes);
+
+  reinterpret_cast<UringFile*>(file)->state = state;
+  file->pMethods = &kIoMethods;
+  return SQLITE_OK;
+}
+
+}  // namespace
+
+void register_uring_vfs(const uring_vfs_options& options) {
+  if (sqlite3_vfs_find(kUringVfsName))
+    return;
+
+  auto* base_vfs = sqlite3_vfs_find(nullptr);
+  // Relies on the file layout of the unix VFS.
+  if (!base_vfs || std::strcmp(base_vfs->zName, "unix") != 0)
+    throw Exception{"The default VFS is not the unix one"};
+
+  vfs_options = options;
+  vfs_options.queue_depth = std::max(vfs_options.queue_depth, 2u);
+  ring_available = GetThreadRing() != nullptr;
+
+  // Everything except opening files is forwarded to the default VFS.
+  uring_vfs = {
+      .iVersion = std::min(base_vfs->iVersion, 3),
+      .szOsFile = static_cast<int>(kRealFileOffset) + base_vfs->szOsFile,
+      .mxPathname = base_vfs->mxPathname,
+      .zName = kUringVfsName,
+      .pAppData = base_vfs,
+      .xOpen = &Open,
+      .xDelete =
+          [](sqlite3_vfs* vfs, const char* name, int sync_dir) {
+            return GetBaseVfs(vfs)->xDelete(GetBaseVfs(vfs), name, sync_dir);
+          },
+      .xAccess =
+          [](sqlite3_vfs* vfs, const char* name, int flags, int* result) {
+            return GetBaseVfs(vfs)->xAccess(GetBaseVfs(vfs), name, flags,
+                                            result);
+          },
+      .xFullPathname =
+          [](sqlite3_vfs* vfs, const char* name, int size, char* result) {
+            return GetBaseVfs(vfs)->xFullPathname(GetBaseVfs(vfs), name, size,
+                                                  result);
+          },
+      .xDlOpen =
+          [](sqlite3_vfs* vfs, const char* name) {
+            return GetBaseVfs(vfs)->xDlOpen(GetBaseVfs(vfs), name);
+          },
+      .xDlError =
+          [](sqlite3_vfs* vfs, int size, char* message) {
+            GetBaseVfs(vfs)->xDlError(GetBaseVfs(vfs), size, message);
+          },
+      .xDlSym = [](sqlite3_vfs* vfs, void* handle,
+                   const char* symbol) -> void (*)(void) {
+        return GetBaseVfs(vfs)->xDlSym(GetBaseVfs(vfs), handle, symbol);
+      },
+      .xDlClose =
+          [](sqlite3_vfs* vfs, void* handle) {
+            GetBaseVfs(vfs)->xDlClose(GetBaseVfs(vfs), handle);
+          },
+      .xRandomness =
+          [](sqlite3_vfs* vfs, int size, char* result) {
+            return GetBaseVfs(vfs)->xRandomness(GetBaseVfs(vfs), size, result);
+          },
+      .xSleep =
+          [](sqlite3_vfs* vfs, int microseconds) {
+            return GetBaseVfs(vfs)->xSleep(GetBaseVfs(vfs), microseconds);
+          },
+      .xCurrentTime =
+          [](sqlite3_vfs* vfs, double* result) {
+            return GetBaseVfs(vfs)->xCurrentTime(GetBaseVfs(vfs), result);
+          },
+      .xGetLastError =
+          [](sqlite3_vfs* vfs, int size, char* message) {
+            return GetBaseVfs(vfs)->xGetLastError(GetBaseVfs(vfs), size,
+                                                  message);
+          },
+      .xCurrentTimeInt64 =
+          [](sqlite3_vfs* vfs, sqlite3_int64* result) {
+            return GetBaseVfs(vfs)->xCurrentTimeInt64(GetBaseVfs(vfs), result);
+          },
+      .xSetSystemCall =
+          [](sqlite3_vfs* vfs, const char* name, sqlite3_syscall_ptr call) {
+            return GetBaseVfs(vfs)->xSetSystemCall(GetBaseVfs(vfs), name,
+                                                   call);
+          },
+      .xGetSystemCall =
+          [](sqlite3_vfs* vfs, const char* name) {
+            return GetBaseVfs(vfs)->xGetSystemCall(GetBaseVfs(vfs), name);
+          },
+      .xNextSystemCall =
+          [](sqlite3_vfs* vfs, const char* name) {
+            return GetBaseVfs(vfs)->xNextSystemCall(GetBaseVfs(vfs), name);
+          }};
+
+  if (int result = sqlite3_vfs_register(&uring_vfs, 0); result != SQLITE_OK)
+    throw Exception{sqlite3_errstr(result)};
+}
+
+uring_vfs_status get_uring_vfs_status() {
+  return {.available = ring_available,
+          .uring_file_count = uring_file_count,
+          .submission_count = submission_count};
+}
+
+#else
+
+void register_uring_vfs(const uring_vfs_options& options) {
+  throw Exception{"io_uring is only available on Linux"};
+}
+
+uring_vfs_status get_uring_vfs_status() {
+  return {};
+}
+
+#endif
+
+}  // namespace sql::sqlite3
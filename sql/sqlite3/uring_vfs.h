@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace sql::sqlite3 {
+
+inline constexpr char kUringVfsName[] = "uring";
+
+struct uring_vfs_options {
+  // Submission queue entries of the ring of each thread. A thread's requests
+  // are submitted through its own ring, so threads do not wait for each
+  // other.
+  unsigned queue_depth = 32;
+  // Writes are buffered and adjacent pages are merged into single requests.
+  // The buffer is flushed when it grows above this size, and before syncs,
+  // overlapping reads, lock changes and WAL index access.
+  size_t max_pending_bytes = 4 * 1024 * 1024;
+};
+
+// Registers a VFS named |kUringVfsName| that reads and writes the database,
+// journal and WAL files through io_uring. A sync is submitted as an
+// fdatasync linked after the pending writes. Locking, shared memory and the
+// other files are left to the default VFS, which is also used for all files
+// if the kernel does not support io_uring, and for the files whose descriptor
+// cannot be obtained from the default VFS. Select it with |open_params::vfs|.
+//
+// Linux only. Must be called before opening connections that use it.
+// Registering again has no effect.
+void register_uring_vfs(const uring_vfs_options& options = {});
+
+struct uring_vfs_status {
+  // False if the VFS is not registered or the kernel does not support
+  // io_uring.
+  bool available = false;
+  // Files opened through io_uring, and requests submitted for them.
+  int64_t uring_file_count = 0;
+  int64_t submission_count = 0;
+};
+
+uring_vfs_status get_uring_vfs_status();
+
+}  // namespace sql::sqlite3
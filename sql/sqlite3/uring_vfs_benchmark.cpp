@@ -0,0 +1,121 @@
+#include "sql/sqlite3/connection.h"
+#include "sql/sqlite3/statement.h"
+#include "sql/sqlite3/test/benchmark_database.h"
+#include "sql/sqlite3/uring_vfs.h"
+
+#include <benchmark/benchmark.h>
+#include <format>
+
+namespace sql::sqlite3 {
+
+namespace {
+
+// Indexed by the first benchmark argument. An empty name is the default VFS.
+// `register_uring_vfs` throws on other platforms.
+#if defined(__linux__)
+constexpr const char* kVfsNames[] = {"", kUringVfsName};
+#else
+constexpr const char* kVfsNames[] = {""};
+#endif
+
+constexpr std::pair<journal_mode, const char*> kJournalModes[] = {
+    {journal_mode::DELETE, "delete"},
+    {journal_mode::WAL, "wal"},
+};
+
+constexpr int kRowCount = 100'000;
+
+// Opens a durable database on the VFS and in the journal mode selected by the
+// benchmark arguments.
+open_params GetOpenParams(const benchmark::State& state) {
+  const char* vfs = kVfsNames[state.range(0)];
+  if (*vfs)
+    register_uring_vfs();
+  return {.vfs = vfs,
+          .journal = kJournalModes[state.range(1)].first,
+          .synchronous = synchronous_mode::FULL};
+}
+
+void SetLabel(benchmark::State& state) {
+  state.SetLabel(std::format("{}/{}",
+                             *kVfsNames[state.range(0)]
+                                 ? kVfsNames[state.range(0)]
+                                 : "default",
+                             kJournalModes[state.range(1)].second));
+}
+
+// One row per transaction. Dominated by the sync latency.
+void BM_VfsInsertCommit(benchmark::State& state) {
+  BenchmarkDatabase database{GetOpenParams(state)};
+  statement insert{database.get(), "INSERT INTO t(a, b) VALUES(?, ?)"};
+
+  int i = 0;
+  for (auto _ : state) {
+    insert.bind(0, i++);
+    insert.bind(1, "value");
+    insert.query();
+    insert.reset();
+  }
+
+  state.SetItemsProcessed(state.iterations());
+  SetLabel(state);
+}
+
+// Random updates of 100 rows per transaction. Each commit writes many
+// scattered pages, some of them adjacent.
+void BM_VfsUpdateBatch(benchmark::State& state) {
+  constexpr int kBatchSize = 100;
+
+  BenchmarkDatabase database{GetOpenParams(state)};
+  database.Populate(kRowCount);
+  statement update{database.get(), "UPDATE t SET b=? WHERE id=?"};
+
+  int i = 0;
+  for (auto _ : state) {
+    database.get().start();
+    for (int j = 0; j < kBatchSize; ++j) {
+      update.bind(0, std::format("updated {}", i));
+      update.bind(1, 1 + (i++ * 7919) % kRowCount);
+      update.query();
+      update.reset();
+    }
+    database.get().commit();
+  }
+
+  state.SetItemsProcessed(state.iterations() * kBatchSize);
+  SetLabel(state);
+}
+
+// Point reads that miss a small page cache.
+void BM_VfsPointSelect(benchmark::State& state) {
+  BenchmarkDatabase database{GetOpenParams(state)};
+  database.Populate(kRowCount);
+  database.get().query("PRAGMA cache_size=16");
+
+  statement select{database.get(), "SELECT a, b FROM t WHERE id=?"};
+
+  int i = 0;
+  for (auto _ : state) {
+    select.bind(0, 1 + (i++ * 7919) % kRowCount);
+    benchmark::DoNotOptimize(select.next());
+    benchmark::DoNotOptimize(select.at(1).as_string_view());
+    select.reset();
+  }
+
+  state.SetItemsProcessed(state.iterations());
+  SetLabel(state);
+}
+
+void VfsArguments(benchmark::internal::Benchmark* benchmark) {
+  benchmark->ArgsProduct(
+      {benchmark::CreateDenseRange(0, std::size(kVfsNames) - 1, /*step=*/1),
+       {0, std::size(kJournalModes) - 1}});
+}
+
+}  // namespace
+
+BENCHMARK(BM_VfsInsertCommit)->Apply(VfsArguments);
+BENCHMARK(BM_VfsUpdateBatch)->Apply(VfsArguments);
+BENCHMARK(BM_VfsPointSelect)->Apply(VfsArguments);
+
+}  // namespace sql::sqlite3
@@ -0,0 +1,153 @@
+#include "sql/sqlite3/uring_vfs.h"
+
+#include "sql/sqlite3/connection.h"
+#include "sql/sqlite3/statement.h"
+#include "sql/test/temp_dir.h"
+
+#include <format>
+#include <gmock/gmock.h>
+#include <thread>
+#include <vector>
+
+namespace sql::sqlite3 {
+
+namespace {
+
+constexpr int kRowCount = 10'000;
+
+void InsertRows(connection& connection, int begin, int end) {
+  statement insert{connection, "INSERT INTO t VALUES(?, ?)"};
+  connection.start();
+  for (int i = begin; i < end; ++i) {
+    insert.bind(0, i);
+    insert.bind(1, std::string(100 + i % 100, 'x'));
+    insert.query();
+    insert.reset();
+  }
+  connection.commit();
+}
+
+int64_t CountRows(connection& connection) {
+  statement count{connection, "SELECT COUNT(*) FROM t"};
+  count.next();
+  return count.at(0).as_int64();
+}
+
+}  // namespace
+
+class UringVfsTest : public testing::TestWithParam<journal_mode> {
+ public:
+  virtual void SetUp() override {
+#if defined(__linux__)
+    register_uring_vfs();
+    if (!get_uring_vfs_status().available)
+      GTEST_SKIP() << "io_uring is not supported by the kernel";
+#else
+    GTEST_SKIP() << "io_uring is only available on Linux";
+#endif
+  }
+};
+
+TEST_P(UringVfsTest, ReadsWhatWasWritten) {
+  ScopedTempDir temp_dir;
+  auto path = temp_dir.get() / "test.sqlite3";
+  auto status = get_uring_vfs_status();
+
+  {
+    connection connection;
+    connection.open({.path = path,
+                     .vfs = kUringVfsName,
+                     .journal = GetParam(),
+                     .synchronous = synchronous_mode::FULL,
+                     .cache_size = 16});
+    connection.query("CREATE TABLE t(id INTEGER PRIMARY KEY, v TEXT)");
+
+    // Another connection of the default VFS sees every commit.
+    sql::sqlite3::connection reader;
+    reader.open({.path = path});
+
+    for (int i = 0; i < kRowCount; i += kRowCount / 10) {
+      InsertRows(connection, i, i + kRowCount / 10);
+      EXPECT_EQ(CountRows(reader), i + kRowCount / 10);
+    }
+
+    // Updates rewrite pages in place and read them back from a small cache.
+    connection.query("UPDATE t SET v = 'y' WHERE id % 3 = 0");
+    EXPECT_EQ(CountRows(connection), kRowCount);
+  }
+
+  // The files went through io_uring rather than the default VFS.
+  EXPECT_GT(get_uring_vfs_status().uring_file_count, status.uring_file_count);
+  EXPECT_GT(get_uring_vfs_status().submission_count, status.submission_count);
+
+  connection connection;
+  connection.open({.path = path});
+  statement check{connection, "PRAGMA integrity_check"};
+  ASSERT_TRUE(check.next());
+  EXPECT_EQ(check.at(0).as_string(), "ok");
+
+  statement select{connection, "SELECT COUNT(*) FROM t WHERE v = 'y'"};
+  ASSERT_TRUE(select.next());
+  EXPECT_EQ(select.at(0).as_int64(), (kRowCount + 2) / 3);
+}
+
+// Without syncs on commit the buffered WAL frames are written out before the
+// WAL index publishes them to other connections.
+TEST_P(UringVfsTest, PublishesUnsyncedCommits) {
+  ScopedTempDir temp_dir;
+  auto path = temp_dir.get() / "test.sqlite3";
+
+  connection connection;
+  connection.open({.path = path,
+                   .vfs = kUringVfsName,
+                   .journal = GetParam(),
+                   .synchronous = synchronous_mode::NORMAL});
+  connection.query("CREATE TABLE t(id INTEGER PRIMARY KEY, v TEXT)");
+
+  sql::sqlite3::connection reader;
+  reader.open({.path = path});
+
+  for (int i = 0; i < kRowCount; i += kRowCount / 10) {
+    InsertRows(connection, i, i + kRowCount / 10);
+    EXPECT_EQ(CountRows(reader), i + kRowCount / 10);
+  }
+
+  statement check{reader, "PRAGMA integrity_check"};
+  ASSERT_TRUE(check.next());
+  EXPECT_EQ(check.at(0).as_string(), "ok");
+}
+
+// Each thread submits through its own ring.
+TEST_P(UringVfsTest, WritesFromSeveralThreads) {
+  constexpr int kThreadCount = 4;
+
+  ScopedTempDir temp_dir;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kThreadCount; ++i) {
+    threads.emplace_back([&temp_dir, i] {
+      connection connection;
+      connection.open({.path = temp_dir.get() / std::format("{}.sqlite3", i),
+                       .vfs = kUringVfsName,
+                       .journal = GetParam(),
+                       .synchronous = synchronous_mode::FULL});
+      connection.query("CREATE TABLE t(id INTEGER PRIMARY KEY, v TEXT)");
+      for (int j = 0; j < kRowCount; j += kRowCount / 10)
+        InsertRows(connection, j, j + kRowCount / 10);
+    });
+  }
+  for (auto& thread : threads)
+    thread.join();
+
+  for (int i = 0; i < kThreadCount; ++i) {
+    connection connection;
+    connection.open({.path = temp_dir.get() / std::format("{}.sqlite3", i)});
+    EXPECT_EQ(CountRows(connection), kRowCount);
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(JournalModes,
+                         UringVfsTest,
+                         testing::Values(journal_mode::DELETE,
+                                         journal_mode::WAL));
+
+}  // namespace sql::sqlite3
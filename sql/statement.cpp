@@ -50,6 +50,29 @@ void statement::bind(unsigned column, std::u16string_view value) {
   model_->bind(column, value);
 }
 
+void statement::bind_params(std::span<const param_value> params) {
+  model_->bind_params(params);
+}
+
+void statement::bind_key_set(std::span<const param_value> keys) {
+  model_->bind_key_set(keys);
+}
+
+int64_t statement::execute_batch(std::span<const param_value> params,
+                                 size_t row_count) {
+  return model_->execute_batch(params, row_count);
+}
+
+std::span<const column_info> statement::columns() const {
+  assert(model_);
+  return model_->columns();
+}
+
+std::optional<unsigned> statement::find_column(std::string_view name) const {
+  assert(model_);
+  return model_->find_column(name);
+}
+
 size_t statement::field_count() const {
   return model_->field_count();
 }
@@ -63,6 +86,11 @@ field_view statement::at(unsigned column) const {
   return field_view{*model_, static_cast<int>(column)};
 }
 
+void statement::read_fields(std::span<const column_target> targets) const {
+  assert(model_);
+  model_->read_fields(targets);
+}
+
 void statement::query() {
   model_->query();
 }
@@ -75,6 +103,10 @@ void statement::reset() {
   model_->reset();
 }
 
+size_t statement::fetch_batch(column_batch& batch, size_t max_rows) {
+  return model_->fetch_batch(batch, max_rows);
+}
+
 void statement::close() {
   if (model_) {
     model_->close();
@@ -82,4 +114,8 @@ void statement::close() {
   }
 }
 
+query_plan statement::explain() const {
+  return model_->explain();
+}
+
 }  // namespace sql
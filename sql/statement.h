@@ -1,10 +1,16 @@
 #pragma once
 
+#include "sql/column_batch.h"
 #include "sql/connection.h"
 #include "sql/field_view.h"
+#include "sql/param.h"
+#include "sql/row.h"
 
 #include <memory>
+#include <optional>
+#include <span>
 #include <string>
+#include <tuple>
 
 namespace sql {
 
@@ -39,16 +45,78 @@ class statement {
   void bind(unsigned column, std::string_view value);
   void bind(unsigned column, std::u16string_view value);
 
+  // Binds |params| to the parameters from the first one with a single driver
+  // call.
+  void bind_params(std::span<const param_value> params);
+
+  // Binds |keys| to a statement prepared from `connection::key_set_sql`.
+  void bind_key_set(std::span<const param_value> keys);
+
+  // Binds |args| to the parameters in order. An empty `std::optional` binds
+  // NULL.
+  template <class... Args>
+  void bind_all(const Args&... args) {
+    sql::internal::bind_all(*this, args...);
+  }
+
+  // Binds |args|, runs the statement and resets it.
+  template <class... Args>
+  void execute(const Args&... args) {
+    sql::internal::execute(*this, args...);
+  }
+
+  // Runs the statement once per element of |rows|, a range of tuples or
+  // aggregates, and returns the affected row count of each driver call.
+  template <std::ranges::input_range Rows>
+  std::vector<int64_t> execute_batch(Rows&& rows) {
+    return sql::internal::execute_batch(*this, std::forward<Rows>(rows));
+  }
+
+  // Runs the statement |row_count| times, binding consecutive equal slices of
+  // |params|, with a single driver call. Returns the total affected row count.
+  int64_t execute_batch(std::span<const param_value> params, size_t row_count);
+
   size_t field_count() const;
+
+  // Describes the result columns. Computed once per prepared statement.
+  std::span<const column_info> columns() const;
+  // Returns the index of the result column named |name|.
+  std::optional<unsigned> find_column(std::string_view name) const;
   field_type type(unsigned column) const;
   field_view at(unsigned column) const;
 
+  // Decodes the current row into |targets| with a single driver call.
+  void read_fields(std::span<const column_target> targets) const;
+
+  // Reads the current row as a tuple. NULL values map to empty
+  // `std::optional`s and to default values of other types.
+  template <class... Ts>
+  std::tuple<Ts...> read_row() const {
+    std::tuple<Ts...> row;
+    internal::read_row(*this, row);
+    return row;
+  }
+
+  // Fills the members of the aggregate |row| in declaration order.
+  template <class Row>
+  void read_row(Row& row) const {
+    internal::read_row(*this, row);
+  }
+
   void query();
   bool next();
   void reset();
 
+  // Reads up to |max_rows| rows into |batch| and returns their count, which is
+  // 0 once the rows are exhausted. See `column_batch`.
+  size_t fetch_batch(column_batch& batch, size_t max_rows);
+
   void close();
 
+  // Returns the plan of the statement. See `open_params::full_scan_handler`
+  // for automatic full scan detection.
+  query_plan explain() const;
+
  private:
   std::unique_ptr<connection::statement_model> model_;
 };
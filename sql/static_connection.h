@@ -0,0 +1,381 @@
+#pragma once
+
+#include "sql/column_batch.h"
+#include "sql/param.h"
+#include "sql/fetch_many.h"
+#include "sql/query_range.h"
+#include "sql/row.h"
+#include "sql/types.h"
+
+#if !defined(SQL_SINGLE_BACKEND_POSTGRESQL)
+#include "sql/sqlite3/connection.h"
+#include "sql/sqlite3/statement.h"
+#endif
+
+#if !defined(SQL_SINGLE_BACKEND_SQLITE3)
+#include "sql/postgresql/connection.h"
+#include "sql/postgresql/statement.h"
+#endif
+
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace sql {
+
+namespace internal {
+
+template <class Connection>
+bool is_driver(std::string_view driver);
+
+#if !defined(SQL_SINGLE_BACKEND_POSTGRESQL)
+template <>
+inline bool is_driver<sqlite3::connection>(std::string_view driver) {
+  return driver.empty() || driver == "sqlite" || driver == "sqlite3";
+}
+#endif
+
+#if !defined(SQL_SINGLE_BACKEND_SQLITE3)
+template <>
+inline bool is_driver<postgresql::connection>(std::string_view driver) {
+  return driver == "postgres" || driver == "postgresql";
+}
+#endif
+
+}  // namespace internal
+
+template <class... Connections>
+class basic_static_statement;
+
+// The API of `sql::connection`, but the driver is held in a `std::variant`
+// instead of a heap-allocated model, and calls are dispatched with
+// `std::visit` instead of virtual calls. With a single driver every call
+// resolves at compile time. Not movable, as the drivers are not.
+template <class... Connections>
+class basic_static_connection {
+ public:
+  using statement = basic_static_statement<Connections...>;
+
+  basic_static_connection() = default;
+  explicit basic_static_connection(const open_params& params) { open(params); }
+
+  basic_static_connection(const basic_static_connection&) = delete;
+  basic_static_connection& operator=(const basic_static_connection&) = delete;
+
+  void open(const open_params& params) {
+    EmplaceDriver(params.driver);
+    visit([&params](auto& connection) { connection.open(params); });
+  }
+
+  void close() {
+    visit([](auto& connection) { connection.close(); });
+  }
+
+  void query(std::string_view sql) {
+    visit([sql](auto& connection) { connection.query(sql); });
+  }
+
+  template <class Row, class... Args>
+  query_range<Row, statement> query(std::string_view sql,
+                                    const Args&... args) {
+    return {*this, sql, args...};
+  }
+
+  template <class Row, std::ranges::input_range Keys>
+  auto fetch_many(std::string_view sql, Keys&& keys) {
+    return internal::fetch_many<Row>(*this, sql, keys);
+  }
+  std::string key_set_sql(std::string_view sql, size_t key_count) const {
+    return visit([sql, key_count](const auto& connection) {
+      return connection.key_set_sql(sql, key_count);
+    });
+  }
+
+  void start() {
+    visit([](auto& connection) { connection.start(); });
+  }
+  void start(const transaction_options& options) {
+    visit([&options](auto& connection) { connection.start(options); });
+  }
+  void commit() {
+    visit([](auto& connection) { connection.commit(); });
+  }
+  void rollback() {
+    visit([](auto& connection) { connection.rollback(); });
+  }
+
+  void savepoint(std::string_view name) {
+    visit([name](auto& connection) { connection.savepoint(name); });
+  }
+  void release_savepoint(std::string_view name) {
+    visit([name](auto& connection) { connection.release_savepoint(name); });
+  }
+  void rollback_to_savepoint(std::string_view name) {
+    visit(
+        [name](auto& connection) { connection.rollback_to_savepoint(name); });
+  }
+
+  int last_change_count() const {
+    return visit(
+        [](const auto& connection) { return connection.last_change_count(); });
+  }
+
+  bool table_exists(std::string_view table_name) const {
+    return visit([table_name](const auto& connection) {
+      return connection.table_exists(table_name);
+    });
+  }
+  bool field_exists(std::string_view table_name,
+                    std::string_view column_name) const {
+    return visit([table_name, column_name](const auto& connection) {
+      return connection.field_exists(table_name, column_name);
+    });
+  }
+  bool index_exists(std::string_view table_name,
+                    std::string_view index_name) const {
+    return visit([table_name, index_name](const auto& connection) {
+      return connection.index_exists(table_name, index_name);
+    });
+  }
+
+  std::vector<field_info> table_fields(std::string_view table_name) const {
+    return visit([table_name](const auto& connection) {
+      return connection.table_fields(table_name);
+    });
+  }
+
+  // Calls |f| with the driver connection.
+  template <class F>
+  decltype(auto) visit(F&& f) {
+    return std::visit(std::forward<F>(f), connection_);
+  }
+  template <class F>
+  decltype(auto) visit(F&& f) const {
+    return std::visit(std::forward<F>(f), connection_);
+  }
+
+ private:
+  template <size_t I = 0>
+  void EmplaceDriver(std::string_view driver) {
+    if constexpr (I == sizeof...(Connections)) {
+      throw std::runtime_error{"Unknown SQL driver"};
+    } else {
+      using Connection =
+          std::variant_alternative_t<I, std::variant<Connections...>>;
+      if (internal::is_driver<Connection>(driver))
+        connection_.template emplace<I>();
+      else
+        EmplaceDriver<I + 1>(driver);
+    }
+  }
+
+  std::variant<Connections...> connection_;
+};
+
+template <class Statement>
+class basic_static_field_view {
+ public:
+  bool is_null() const { return type() == field_type::EMPTY; }
+  field_type type() const { return statement_.type(column_); }
+
+  bool as_bool() const {
+    return Visit([](const auto& field) { return field.as_bool(); });
+  }
+  int as_int() const {
+    return Visit([](const auto& field) { return field.as_int(); });
+  }
+  int64_t as_int64() const {
+    return Visit([](const auto& field) { return field.as_int64(); });
+  }
+  double as_double() const {
+    return Visit([](const auto& field) { return field.as_double(); });
+  }
+  std::string_view as_string_view() const {
+    return Visit([](const auto& field) { return field.as_string_view(); });
+  }
+  std::string as_string() const {
+    return Visit([](const auto& field) { return field.as_string(); });
+  }
+  std::u16string as_string16() const {
+    return Visit([](const auto& field) { return field.as_string16(); });
+  }
+
+ private:
+  basic_static_field_view(const Statement& statement, unsigned column)
+      : statement_{statement}, column_{column} {}
+
+  template <class F>
+  decltype(auto) Visit(F&& f) const {
+    return statement_.visit([this, &f](const auto& statement) {
+      return f(statement.at(column_));
+    });
+  }
+
+  const Statement& statement_;
+  const unsigned column_;
+
+  friend Statement;
+};
+
+// The API of `sql::statement` for `basic_static_connection`.
+template <class... Connections>
+class basic_static_statement {
+ public:
+  using connection_type = basic_static_connection<Connections...>;
+  using field_view = basic_static_field_view<basic_static_statement>;
+
+  basic_static_statement() = default;
+  basic_static_statement(connection_type& connection, std::string_view sql) {
+    prepare(connection, sql);
+  }
+
+  basic_static_statement(const basic_static_statement&) = delete;
+  basic_static_statement& operator=(const basic_static_statement&) = delete;
+
+  bool is_prepared() const {
+    return visit([](const auto& statement) { return statement.is_prepared(); });
+  }
+
+  void prepare(connection_type& connection, std::string_view sql) {
+    connection.visit([this, sql](auto& connection) {
+      using Statement = typename std::decay_t<decltype(connection)>::statement;
+      statement_.template emplace<Statement>(connection, sql);
+    });
+  }
+
+  void bind_null(unsigned column) {
+    visit([column](auto& statement) { statement.bind_null(column); });
+  }
+  void bind(unsigned column, bool value) { Bind(column, value); }
+  void bind(unsigned column, int value) { Bind(column, value); }
+  void bind(unsigned column, int64_t value) { Bind(column, value); }
+  void bind(unsigned column, double value) { Bind(column, value); }
+  // Add explicit c-string parameters to avoid implicit cast to `bool`.
+  void bind(unsigned column, const char* value) { Bind(column, value); }
+  void bind(unsigned column, const char16_t* value) { Bind(column, value); }
+  void bind(unsigned column, std::string_view value) { Bind(column, value); }
+  void bind(unsigned column, std::u16string_view value) {
+    Bind(column, value);
+  }
+
+  void bind_params(std::span<const param_value> params) {
+    visit([params](auto& statement) { statement.bind_params(params); });
+  }
+  void bind_key_set(std::span<const param_value> keys) {
+    visit([keys](auto& statement) { statement.bind_key_set(keys); });
+  }
+
+  template <class... Args>
+  void bind_all(const Args&... args) {
+    internal::bind_all(*this, args...);
+  }
+
+  template <class... Args>
+  void execute(const Args&... args) {
+    internal::execute(*this, args...);
+  }
+
+  template <std::ranges::input_range Rows>
+  std::vector<int64_t> execute_batch(Rows&& rows) {
+    return internal::execute_batch(*this, std::forward<Rows>(rows));
+  }
+  int64_t execute_batch(std::span<const param_value> params,
+                        size_t row_count) {
+    return visit([params, row_count](auto& statement) {
+      return statement.execute_batch(params, row_count);
+    });
+  }
+
+  size_t field_count() const {
+    return visit([](const auto& statement) { return statement.field_count(); });
+  }
+  std::span<const column_info> columns() const {
+    return visit([](const auto& statement) { return statement.columns(); });
+  }
+  std::optional<unsigned> find_column(std::string_view name) const {
+    return visit(
+        [name](const auto& statement) { return statement.find_column(name); });
+  }
+  field_type type(unsigned column) const {
+    return visit(
+        [column](const auto& statement) { return statement.type(column); });
+  }
+  field_view at(unsigned column) const { return field_view{*this, column}; }
+
+  void read_fields(std::span<const column_target> targets) const {
+    visit([targets](const auto& statement) { statement.read_fields(targets); });
+  }
+
+  template <class... Ts>
+  std::tuple<Ts...> read_row() const {
+    std::tuple<Ts...> row;
+    internal::read_row(*this, row);
+    return row;
+  }
+
+  template <class Row>
+  void read_row(Row& row) const {
+    internal::read_row(*this, row);
+  }
+
+  void query() {
+    visit([](auto& statement) { statement.query(); });
+  }
+  bool next() {
+    return visit([](auto& statement) { return statement.next(); });
+  }
+  void reset() {
+    visit([](auto& statement) { statement.reset(); });
+  }
+
+  size_t fetch_batch(column_batch& batch, size_t max_rows) {
+    return visit([&batch, max_rows](auto& statement) {
+      return statement.fetch_batch(batch, max_rows);
+    });
+  }
+
+  void close() {
+    visit([](auto& statement) { statement.close(); });
+  }
+
+  query_plan explain() const {
+    return visit([](const auto& statement) { return statement.explain(); });
+  }
+
+  // Calls |f| with the driver statement.
+  template <class F>
+  decltype(auto) visit(F&& f) {
+    return std::visit(std::forward<F>(f), statement_);
+  }
+  template <class F>
+  decltype(auto) visit(F&& f) const {
+    return std::visit(std::forward<F>(f), statement_);
+  }
+
+ private:
+  template <class T>
+  void Bind(unsigned column, T value) {
+    visit([column, value](auto& statement) { statement.bind(column, value); });
+  }
+
+  std::variant<typename Connections::statement...> statement_;
+};
+
+#if defined(SQL_SINGLE_BACKEND_SQLITE3)
+using static_connection = basic_static_connection<sqlite3::connection>;
+#elif defined(SQL_SINGLE_BACKEND_POSTGRESQL)
+using static_connection = basic_static_connection<postgresql::connection>;
+#else
+using static_connection =
+    basic_static_connection<sqlite3::connection, postgresql::connection>;
+#endif
+
+using static_statement = static_connection::statement;
+
+}  // namespace sql
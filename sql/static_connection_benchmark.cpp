@@ -0,0 +1,129 @@
+#include "sql/connection.h"
+#include "sql/statement.h"
+#include "sql/static_connection.h"
+
+#include <benchmark/benchmark.h>
+#include <filesystem>
+#include <format>
+
+// The benchmarks read a SQLite database file.
+#if !defined(SQL_SINGLE_BACKEND_POSTGRESQL)
+
+namespace sql {
+
+namespace {
+
+constexpr int kRowCount = 10'000;
+
+// Compares the dispatch overhead of the type-erased `sql::connection`, the
+// variant-based `sql::static_connection` and the driver connection itself on
+// a tight read loop over a cached table.
+template <class Connection>
+class Database {
+ public:
+  Database()
+      : path_{std::filesystem::temp_directory_path() /
+              "sql_static_connection_benchmark.sqlite3"} {
+    std::filesystem::remove(path_);
+    connection_.open({.driver = "sqlite", .path = path_});
+    connection_.query("CREATE TABLE t(a INTEGER, b REAL, c TEXT)");
+
+    typename Connection::statement insert{connection_,
+                                          "INSERT INTO t VALUES(?, ?, ?)"};
+    connection_.start();
+    for (int i = 0; i < kRowCount; ++i) {
+      insert.bind(0, i);
+      insert.bind(1, i * 0.5);
+      insert.bind(2, std::format("value {}", i));
+      insert.query();
+      insert.reset();
+    }
+    connection_.commit();
+  }
+
+  ~Database() {
+    connection_.close();
+    std::filesystem::remove(path_);
+  }
+
+  Connection& get() { return connection_; }
+
+ private:
+  const std::filesystem::path path_;
+  Connection connection_;
+};
+
+template <class Connection>
+void BM_ReadRows(benchmark::State& state) {
+  Database<Connection> database;
+  typename Connection::statement select{database.get(),
+                                        "SELECT a, b, c FROM t"};
+
+  for (auto _ : state) {
+    int64_t sum = 0;
+    while (select.next()) {
+      sum += select.at(0).as_int64();
+      sum += static_cast<int64_t>(select.at(1).as_double());
+      sum += select.at(2).as_string_view().size();
+    }
+    select.reset();
+    benchmark::DoNotOptimize(sum);
+  }
+
+  state.SetItemsProcessed(state.iterations() * kRowCount);
+}
+
+// Same as `BM_ReadRows`, but decodes each row with a single call.
+template <class Connection>
+void BM_ReadRowsWhole(benchmark::State& state) {
+  Database<Connection> database;
+  typename Connection::statement select{database.get(),
+                                        "SELECT a, b, c FROM t"};
+
+  for (auto _ : state) {
+    int64_t sum = 0;
+    while (select.next()) {
+      auto [a, b, c] =
+          select.template read_row<int64_t, double, std::string_view>();
+      sum += a + static_cast<int64_t>(b) + c.size();
+    }
+    select.reset();
+    benchmark::DoNotOptimize(sum);
+  }
+
+  state.SetItemsProcessed(state.iterations() * kRowCount);
+}
+
+template <class Connection>
+void BM_PointSelect(benchmark::State& state) {
+  Database<Connection> database;
+  typename Connection::statement select{database.get(),
+                                        "SELECT c FROM t WHERE rowid = ?"};
+
+  int64_t rowid = 0;
+  for (auto _ : state) {
+    select.bind(0, rowid % kRowCount + 1);
+    select.next();
+    benchmark::DoNotOptimize(select.at(0).as_string_view());
+    select.reset();
+    ++rowid;
+  }
+}
+
+BENCHMARK(BM_ReadRows<sql::connection>);
+BENCHMARK(BM_ReadRows<sql::static_connection>);
+BENCHMARK(BM_ReadRows<sql::sqlite3::connection>);
+
+BENCHMARK(BM_ReadRowsWhole<sql::connection>);
+BENCHMARK(BM_ReadRowsWhole<sql::static_connection>);
+BENCHMARK(BM_ReadRowsWhole<sql::sqlite3::connection>);
+
+BENCHMARK(BM_PointSelect<sql::connection>);
+BENCHMARK(BM_PointSelect<sql::static_connection>);
+BENCHMARK(BM_PointSelect<sql::sqlite3::connection>);
+
+}  // namespace
+
+}  // namespace sql
+
+#endif  // !defined(SQL_SINGLE_BACKEND_POSTGRESQL)
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "sql/connection.h"
+#include "sql/types.h"
+
+#include <format>
+#include <string>
+
+namespace sql {
+
+// Starts a transaction on construction and rolls it back on destruction
+// unless `commit` was called. A transaction constructed from a parent
+// transaction is nested and maps to a savepoint.
+template <class Connection>
+class basic_transaction {
+ public:
+  explicit basic_transaction(Connection& connection,
+                             const transaction_options& options = {})
+      : connection_{connection} {
+    connection_.start(options);
+  }
+
+  explicit basic_transaction(basic_transaction& parent)
+      : connection_{parent.connection_},
+        depth_{parent.depth_ + 1},
+        savepoint_{std::format("sql_savepoint_{}", depth_)} {
+    connection_.savepoint(savepoint_);
+  }
+
+  ~basic_transaction() {
+    if (!finished_) {
+      try {
+        rollback();
+      } catch (...) {
+      }
+    }
+  }
+
+  basic_transaction(const basic_transaction&) = delete;
+  basic_transaction& operator=(const basic_transaction&) = delete;
+
+  bool is_nested() const { return depth_ != 0; }
+
+  // On failure the transaction stays active and is rolled back on
+  // destruction.
+  void commit() {
+    if (is_nested())
+      connection_.release_savepoint(savepoint_);
+    else
+      connection_.commit();
+    finished_ = true;
+  }
+
+  void rollback() {
+    finished_ = true;
+    if (is_nested()) {
+      connection_.rollback_to_savepoint(savepoint_);
+      connection_.release_savepoint(savepoint_);
+    } else {
+      connection_.rollback();
+    }
+  }
+
+ private:
+  Connection& connection_;
+  const int depth_ = 0;
+  const std::string savepoint_;
+  bool finished_ = false;
+};
+
+using transaction = basic_transaction<connection>;
+
+}  // namespace sql
@@ -1,19 +1,106 @@
 #pragma once
 
+#include "sql/query_plan.h"
+
+#include <cstdint>
 #include <filesystem>
+#include <functional>
+#include <optional>
 #include <string>
 
 namespace sql {
 
 enum class field_type { INTEGER = 1, FLOAT = 2, TEXT = 3, BLOB = 4, EMPTY = 5 };
 
+// SQLite locking mode for a transaction.
+enum class transaction_mode { DEFERRED, IMMEDIATE, EXCLUSIVE };
+
+// PostgreSQL isolation level for a transaction.
+enum class isolation_level {
+  DEFAULT,
+  READ_COMMITTED,
+  REPEATABLE_READ,
+  SERIALIZABLE
+};
+
+struct transaction_options {
+  // SQLite only. `IMMEDIATE` takes the write lock on start, so concurrent
+  // writers wait in the busy handler instead of failing on lock upgrade.
+  transaction_mode mode = transaction_mode::DEFERRED;
+
+  // PostgreSQL only.
+  isolation_level isolation = isolation_level::DEFAULT;
+  bool read_only = false;
+  bool deferrable = false;
+};
+
+// SQLite storage tuning. The numeric values match the SQLite PRAGMA values.
+
+enum class journal_mode { DELETE, TRUNCATE, PERSIST, MEMORY, WAL, OFF };
+enum class synchronous_mode { OFF, NORMAL, FULL, EXTRA };
+enum class temp_store_mode { DEFAULT, FILE, MEMORY };
+
+// Named presets for the SQLite tuning fields of `open_params`. Fields set
+// explicitly take precedence over the profile.
+enum class performance_profile {
+  // SQLite defaults.
+  DEFAULT,
+  // WAL with a full sync on every commit and a moderate cache. Every
+  // committed transaction survives a power loss.
+  DURABLE_OLTP,
+  // WAL without syncs, a large cache and in-memory temporary storage. The
+  // database stays consistent after an application crash, but recent
+  // commits may be lost on a power loss.
+  BULK_LOAD,
+  // Memory-mapped reads, a large cache, in-memory sorting and worker threads
+  // for large scans.
+  READ_ONLY_ANALYTICS,
+};
+
 struct open_params {
   std::string driver;
   std::filesystem::path path;
   std::string connection_string;
   bool exclusive_locking = false;
   bool multithreaded = false;
+  // SQLite only. Opens an existing database without write access.
+  bool read_only = false;
+  // SQLite only. Promises that nobody modifies the database file while it is
+  // open, e.g. for reference data shipped with a release. Implies
+  // |read_only|. SQLite skips all locking and change detection, and the
+  // whole file is memory-mapped unless |mmap_size| is set, so pages are read
+  // without copying. Any number of threads can read it, each through its own
+  // connection.
+  bool immutable = false;
   int journal_size_limit = -1;
+  // SQLite only. Name of a registered VFS, e.g. the io_uring one. Empty
+  // selects the default VFS.
+  std::string vfs;
+  // SQLite only. Milliseconds to retry with backoff on a locked database
+  // before failing with `SQLITE_BUSY`. Disabled when negative.
+  int busy_timeout = -1;
+
+  // SQLite only. Unset fields keep the SQLite defaults unless |profile|
+  // specifies them.
+  performance_profile profile = performance_profile::DEFAULT;
+  std::optional<journal_mode> journal;
+  std::optional<synchronous_mode> synchronous;
+  // Bytes of the database file to memory-map.
+  std::optional<int64_t> mmap_size;
+  // Positive values are pages, negative values are KiB.
+  std::optional<int> cache_size;
+  // Has effect only for new databases.
+  std::optional<int> page_size;
+  std::optional<temp_store_mode> temp_store;
+  // Auxiliary threads a single statement may use for sorting.
+  std::optional<int> worker_threads;
+
+  // Debugging aid. When set, every prepared statement is explained and the
+  // handler is called for each full scan of a table holding at least
+  // |full_scan_row_threshold| rows.
+  std::function<void(std::string_view sql, const query_plan_node& scan)>
+      full_scan_handler;
+  double full_scan_row_threshold = 0;
 };
 
 struct field_info {
@@ -23,4 +110,19 @@ struct field_info {
   bool operator==(const field_info& other) const = default;
 };
 
+// Describes a result column of a statement.
+struct column_info {
+  std::string name;
+  // The type from the table definition, e.g. `INTEGER` or `int8`. Empty for
+  // expressions and unknown types.
+  std::string declared_type;
+  // Unset when unknown. SQLite only knows it for columns read directly from a
+  // table; PostgreSQL doesn't report it.
+  std::optional<bool> nullable;
+  // PostgreSQL type OID. Zero for SQLite.
+  uint32_t type_oid = 0;
+
+  bool operator==(const column_info& other) const = default;
+};
+
 }  // namespace sql
@@ -7,11 +7,17 @@ macro(sql_library TARGET_NAME)
     "*_mock.*"
     "test/*.cpp"
     "test/*.h")
+  file(GLOB ${TARGET_NAME}_BENCHMARK_SOURCES CONFIGURE_DEPENDS
+    "*_benchmark.*")
 
   if (${TARGET_NAME}_UT_SOURCES)
     list(REMOVE_ITEM ${TARGET_NAME}_SOURCES ${${TARGET_NAME}_UT_SOURCES})
   endif()
 
+  if (${TARGET_NAME}_BENCHMARK_SOURCES)
+    list(REMOVE_ITEM ${TARGET_NAME}_SOURCES ${${TARGET_NAME}_BENCHMARK_SOURCES})
+  endif()
+
   add_library(${TARGET_NAME} ${${TARGET_NAME}_SOURCES})
   add_library(Sql::${TARGET_NAME} ALIAS ${TARGET_NAME})
 
@@ -24,4 +30,12 @@ macro(sql_library TARGET_NAME)
         GTest::gmock_main)
     gtest_discover_tests(${TARGET_NAME}_unittests)
   endif()
+
+  if (SQL_BUILD_BENCHMARKS AND ${TARGET_NAME}_BENCHMARK_SOURCES)
+    find_package(benchmark REQUIRED)
+    add_executable(${TARGET_NAME}_benchmarks ${${TARGET_NAME}_BENCHMARK_SOURCES})
+    target_link_libraries(${TARGET_NAME}_benchmarks PUBLIC
+        ${TARGET_NAME}
+        benchmark::benchmark_main)
+  endif()
 endmacro()